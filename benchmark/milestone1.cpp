@@ -1,14 +1,26 @@
+#include "CSVLoader.hpp"
 #include "RowStore.hpp"
 #include "ColumnStore.hpp"
+#include "ColumnGroupStore.hpp"
+#include "MVCC.hpp"
+#include "PaxStore.hpp"
+#include "WriteAheadLog.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <mutable/util/macro.hpp>
+#include <string>
+#include <thread>
 
 
 namespace {
 
-#define store_t(X) X(row), X(column),
+#define store_t(X) X(row), X(column), X(pax), X(group),
 DECLARE_ENUM(store_t);
 const char *store2str[] = { ENUM_TO_STR(store_t) };
 #undef STORE
@@ -21,6 +33,57 @@ constexpr int32_t NUM_TUPLES_RW = 2e7;
 
 }
 
+void benchmark_read_write(m::Diagnostic &diag, m::Table &tbl, const char *query_str, store_t st, const char *suffix)
+{
+    /* Get a handle on the backing store, create a writer, and an I/O tuple. */
+    auto &store = tbl.store();
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+
+    using namespace std::chrono;
+
+    auto t_write_begin = steady_clock::now();
+    for (int32_t i = 0; i != NUM_TUPLES_RW; ++i) {
+        /* Set tuple data (i, 2*i). */
+        tup.set(0, i);
+        tup.set(1, i<<1);
+        W.append(tup);
+    }
+    auto t_write_end = steady_clock::now();
+
+    auto stmt = m::statement_from_string(diag, query_str);
+    std::unique_ptr<m::SelectStmt> query(static_cast<m::SelectStmt*>(stmt.release()));
+
+    auto op = std::make_unique<m::CallbackOperator>([](const m::Schema&, const m::Tuple&){});
+
+    auto t_read_begin = steady_clock::now();
+    m::execute_query(diag, *query, std::move(op));
+    auto t_read_end = steady_clock::now();
+
+    std::cout << "milestone1," << store2str[st] << ",write" << suffix << ','
+              << duration_cast<milliseconds>(t_write_end - t_write_begin).count() << '\n'
+              << "milestone1," << store2str[st] << ",read" << suffix << ','
+              << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << '\n';
+}
+
+/* Write the tuples (i, 2*i) in batches through the bulk append API of `store`. */
+template<typename Store>
+void bulk_write(Store &store)
+{
+    constexpr std::size_t BATCH_SIZE = 1 << 16;
+    store.reserve(NUM_TUPLES_RW);
+    for (int32_t i = 0; i != NUM_TUPLES_RW; ) {
+        const std::size_t n = std::min<std::size_t>(BATCH_SIZE, NUM_TUPLES_RW - i);
+        auto range = store.append(n);
+        for (std::size_t j = 0; j != n; ++j, ++i) {
+            range.set(0, j, i);
+            range.set(1, j, i<<1);
+            range.set_null(0, j, false);
+            range.set_null(1, j, false);
+        }
+    }
+}
+
 void benchmark_store(store_t st)
 {
     /* Clear the catalog before starting a new benchmark. */
@@ -39,6 +102,12 @@ void benchmark_store(store_t st)
     } else if (st == store_t::column) {
         C.register_store<ColumnStore>(C.pool("MyColumnStore"));
         C.default_store(C.pool("MyColumnStore"));
+    } else if (st == store_t::pax) {
+        C.register_store<PaxStore>(C.pool("MyPaxStore"));
+        C.default_store(C.pool("MyPaxStore"));
+    } else if (st == store_t::group) {
+        C.register_store<ColumnGroupStore>(C.pool("MyColumnGroupStore"));
+        C.default_store(C.pool("MyColumnGroupStore"));
     } else {
         assert(false and "invalid store");
     }
@@ -63,7 +132,14 @@ void benchmark_store(store_t st)
         tbl_wide.push_back(C.pool("j_i2"),     m::Type::Get_Integer(m::Type::TY_Vector, 2));
         tbl_wide.push_back(C.pool("k_b"),      m::Type::Get_Boolean(m::Type::TY_Vector));
         tbl_wide.push_back(C.pool("l_i2"),     m::Type::Get_Integer(m::Type::TY_Vector, 2));
-        tbl_wide.store(C.create_store(tbl_wide));
+        if (st == store_t::group) {
+            /* Group the attributes that are read together. */
+            std::istringstream log("SELECT a_i4, e_d, g_f FROM wide; SELECT c_c3, h_c5 FROM wide WHERE b_b;");
+            auto groups = ColumnGroupStore::Propose(tbl_wide, ColumnGroupStore::ReadQueryLog(tbl_wide, log));
+            tbl_wide.store(std::make_unique<ColumnGroupStore>(tbl_wide, groups));
+        } else {
+            tbl_wide.store(C.create_store(tbl_wide));
+        }
 
         auto &store = tbl_wide.store();
         auto &lin = store.linearization();
@@ -89,34 +165,308 @@ void benchmark_store(store_t st)
         tbl_short.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
         tbl_short.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
         tbl_short.store(C.create_store(tbl_short));
+        if (st == store_t::column) // keep compressed copies of the sealed chunks, evaluated below
+            static_cast<ColumnStore&>(tbl_short.store()).enable_compression();
+
+        benchmark_read_write(diag, tbl_short, "SELECT id_a, id_b FROM short;", st, "");
 
-        /* Get a handle on the backing store, create a writer, and an I/O tuple. */
-        auto &store = tbl_short.store();
-        m::StoreWriter W(store);
-        m::Tuple tup(W.schema());
+        /* Evaluate the compression of sealed column chunks and scans that decompress them. */
+        if (st == store_t::column) {
+            auto &store = static_cast<const ColumnStore&>(tbl_short.store());
+
+            using namespace std::chrono;
+            std::size_t sum = 0;
+            auto t_scan_begin = steady_clock::now();
+            for (std::size_t attr = 0; attr != tbl_short.size(); ++attr) {
+                store.scan(attr, [&sum](const char *values, std::size_t n) {
+                    for (std::size_t i = 0; i != n; ++i)
+                        sum += reinterpret_cast<const int32_t*>(values)[i];
+                });
+            }
+            auto t_scan_end = steady_clock::now();
+
+            std::cout << "milestone1," << store2str[st] << ",compressed_size," << store.compressed_size_in_bytes()
+                      << '\n'
+                      << "milestone1," << store2str[st] << ",uncompressed_size," << store.uncompressed_size_in_bytes()
+                      << '\n'
+                      << "milestone1," << store2str[st] << ",read_compressed,"
+                      << duration_cast<milliseconds>(t_scan_end - t_scan_begin).count() << '\n';
+            assert(sum != 0);
+            (void) sum;
+        }
+    }
+
+    /* Evaluate read/write performance with huge pages and interleaved NUMA placement of the store's memory. */
+    {
+        AllocationPolicy policy;
+        policy.huge_pages = true;
+        policy.numa = AllocationPolicy::NUMA_INTERLEAVE;
+
+        auto &tbl_huge = DB.add_table(C.pool("short_huge"));
+        tbl_huge.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_huge.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        if (st == store_t::row)
+            tbl_huge.store(std::make_unique<RowStore>(tbl_huge, policy));
+        else if (st == store_t::column)
+            tbl_huge.store(std::make_unique<ColumnStore>(tbl_huge, policy));
+        else if (st == store_t::pax)
+            tbl_huge.store(std::make_unique<PaxStore>(tbl_huge, policy));
+        else
+            tbl_huge.store(std::make_unique<ColumnGroupStore>(tbl_huge, std::vector<ColumnGroupStore::group_t>(),
+                                                              policy));
+
+        benchmark_read_write(diag, tbl_huge, "SELECT id_a, id_b FROM short_huge;", st, "_hugepages");
+    }
+
+    /* Evaluate write performance when appending tuples in batches instead of one at a time. */
+    if (st != store_t::pax) {
+        auto &tbl_bulk = DB.add_table(C.pool("short_bulk"));
+        tbl_bulk.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_bulk.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_bulk.store(C.create_store(tbl_bulk));
 
         using namespace std::chrono;
 
         auto t_write_begin = steady_clock::now();
-        for (int32_t i = 0; i != NUM_TUPLES_RW; ++i) {
-            /* Set tuple data (i, 2*i). */
-            tup.set(0, i);
-            tup.set(1, i<<1);
-            W.append(tup);
-        }
+        if (st == store_t::row)
+            bulk_write(static_cast<RowStore&>(tbl_bulk.store()));
+        else if (st == store_t::column)
+            bulk_write(static_cast<ColumnStore&>(tbl_bulk.store()));
+        else
+            bulk_write(static_cast<ColumnGroupStore&>(tbl_bulk.store()));
         auto t_write_end = steady_clock::now();
 
-        auto stmt = m::statement_from_string(diag, "SELECT id_a, id_b FROM short;");
-        std::unique_ptr<m::SelectStmt> query(static_cast<m::SelectStmt*>(stmt.release()));
+        std::cout << "milestone1," << store2str[st] << ",write_bulk,"
+                  << duration_cast<milliseconds>(t_write_end - t_write_begin).count() << '\n';
+    }
+
+    /* Evaluate loading a CSV file through the structural indexer of `CSVLoader`. */
+    if (st != store_t::pax) {
+        const std::string filename = std::string(P_tmpdir) + "/milestone1_bench.csv";
+        {
+            std::ofstream out(filename);
+            out << "id_a,id_b\n";
+            for (int32_t i = 0; i != NUM_TUPLES_RW; ++i)
+                out << i << ',' << (i<<1) << '\n';
+        }
+
+        auto &tbl_csv = DB.add_table(C.pool("short_csv"));
+        tbl_csv.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_csv.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_csv.store(C.create_store(tbl_csv));
+
+        using namespace std::chrono;
+
+        auto t_load_begin = steady_clock::now();
+        if (st == store_t::row)
+            CSVLoader::Load(diag, static_cast<RowStore&>(tbl_csv.store()), filename.c_str());
+        else if (st == store_t::column)
+            CSVLoader::Load(diag, static_cast<ColumnStore&>(tbl_csv.store()), filename.c_str());
+        else
+            CSVLoader::Load(diag, static_cast<ColumnGroupStore&>(tbl_csv.store()), filename.c_str());
+        auto t_load_end = steady_clock::now();
+        std::remove(filename.c_str());
+
+        std::cout << "milestone1," << store2str[st] << ",load_csv,"
+                  << duration_cast<milliseconds>(t_load_end - t_load_begin).count() << '\n';
+    }
 
+    /* Evaluate reopening a persistent store, whose rows are already in a file. */
+    if (st == store_t::row or st == store_t::column) {
+        const std::string filename = std::string(P_tmpdir) + "/milestone1_bench.store";
+        auto remove_files = [&]() {
+            for (auto suffix : { "", ".0", ".1" })
+                std::remove((filename + suffix).c_str());
+        };
+        remove_files();
+
+        auto &tbl_file = DB.add_table(C.pool("short_file"));
+        tbl_file.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_file.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        if (st == store_t::row) {
+            RowStore store(tbl_file, filename.c_str());
+            bulk_write(store);
+        } else {
+            ColumnStore store(tbl_file, filename.c_str());
+            bulk_write(store);
+        }
+
+        using namespace std::chrono;
+
+        auto t_open_begin = steady_clock::now();
+        if (st == store_t::row)
+            tbl_file.store(std::make_unique<RowStore>(tbl_file, filename.c_str()));
+        else
+            tbl_file.store(std::make_unique<ColumnStore>(tbl_file, filename.c_str()));
+        auto t_open_end = steady_clock::now();
+
+        auto stmt = m::statement_from_string(diag, "SELECT id_a, id_b FROM short_file;");
+        std::unique_ptr<m::SelectStmt> query(static_cast<m::SelectStmt*>(stmt.release()));
         auto op = std::make_unique<m::CallbackOperator>([](const m::Schema&, const m::Tuple&){});
 
         auto t_read_begin = steady_clock::now();
         m::execute_query(diag, *query, std::move(op));
         auto t_read_end = steady_clock::now();
 
-        std::cout << "milestone1," << store2str[st] << ",write," << duration_cast<milliseconds>(t_write_end - t_write_begin).count() << '\n'
-                  << "milestone1," << store2str[st] << ",read," << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << '\n';
+        std::cout << "milestone1," << store2str[st] << ",reopen,"
+                  << duration_cast<milliseconds>(t_open_end - t_open_begin).count() << '\n'
+                  << "milestone1," << store2str[st] << ",read_reopened,"
+                  << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << '\n';
+        remove_files();
+    }
+
+    /* Evaluate updates through multi-version concurrency control while another thread keeps scanning the table. */
+    if (st == store_t::row) {
+        auto &tbl_mvcc = DB.add_table(C.pool("short_mvcc"));
+        tbl_mvcc.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_mvcc.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_mvcc.store(C.create_store(tbl_mvcc));
+        auto &store = static_cast<RowStore&>(tbl_mvcc.store());
+        bulk_write(store);
+        MVCC mvcc(store);
+
+        constexpr int32_t NUM_UPDATES = NUM_TUPLES_RW / 10;
+        constexpr int32_t UPDATES_PER_TRANSACTION = 8;
+        auto scan = [&mvcc]() {
+            auto &txn = mvcc.begin();
+            int64_t sum = 0;
+            mvcc.scan(txn, [&](std::size_t, const char *row) { sum += mvcc.get<int32_t>(row, 1); });
+            mvcc.commit(txn);
+            return sum;
+        };
+
+        using namespace std::chrono;
+
+        auto t_scan_begin = steady_clock::now();
+        scan();
+        auto t_scan_end = steady_clock::now();
+
+        std::atomic<bool> done(false);
+        std::size_t num_scans = 0;
+        steady_clock::duration t_scans(0);
+        std::thread reader([&]() {
+            auto t_begin = steady_clock::now();
+            while (not done) {
+                scan();
+                ++num_scans;
+            }
+            t_scans = steady_clock::now() - t_begin;
+        });
+
+        auto t_update_begin = steady_clock::now();
+        for (int32_t i = 0; i != NUM_UPDATES; i += UPDATES_PER_TRANSACTION) {
+            auto &txn = mvcc.begin();
+            for (int32_t j = i; j != i + UPDATES_PER_TRANSACTION; ++j)
+                mvcc.update(txn, std::size_t(j) * 7919 % NUM_TUPLES_RW, 1, j);
+            mvcc.commit(txn);
+        }
+        auto t_update_end = steady_clock::now();
+        done = true;
+        reader.join();
+
+        std::cout << "milestone1," << store2str[st] << ",mvcc_update,"
+                  << duration_cast<milliseconds>(t_update_end - t_update_begin).count() << '\n'
+                  << "milestone1," << store2str[st] << ",mvcc_scan,"
+                  << duration_cast<milliseconds>(t_scan_end - t_scan_begin).count() << '\n'
+                  << "milestone1," << store2str[st] << ",mvcc_scan_concurrent,"
+                  << duration_cast<milliseconds>(t_scans).count() / std::max<std::size_t>(num_scans, 1) << '\n';
+    }
+
+    /* Evaluate small committed appends of several threads to a shared write-ahead log, with and without group
+     * commit. */
+    if (st == store_t::row or st == store_t::column) {
+        const std::string filename = std::string(P_tmpdir) + "/milestone1_bench.log";
+        auto &tbl_wal = DB.add_table(C.pool("short_wal"));
+        tbl_wal.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_wal.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+        constexpr unsigned NUM_THREADS = 4;
+        constexpr int32_t NUM_COMMITS = 1000;
+        constexpr int32_t ROWS_PER_COMMIT = 16;
+        auto append_committed = [&](auto &store) {
+            for (int32_t i = 0; i != NUM_COMMITS * ROWS_PER_COMMIT; i += ROWS_PER_COMMIT) {
+                auto range = store.append(ROWS_PER_COMMIT);
+                for (int32_t j = 0; j != ROWS_PER_COMMIT; ++j) {
+                    range.set(0, j, i + j);
+                    range.set(1, j, (i + j)<<1);
+                    range.set_null(0, j, false);
+                    range.set_null(1, j, false);
+                }
+                store.commit();
+            }
+        };
+
+        using namespace std::chrono;
+
+        for (auto interval : { WriteAheadLog::NO_GROUP_COMMIT, microseconds(1000) }) {
+            std::remove(filename.c_str());
+            WriteAheadLog log(filename.c_str(), interval);
+
+            auto t_append_begin = steady_clock::now();
+            std::vector<std::thread> threads;
+            for (unsigned id = 0; id != NUM_THREADS; ++id) {
+                threads.emplace_back([&, id]() {
+                    if (st == store_t::row) {
+                        RowStore store(tbl_wal);
+                        store.attach_log(log, id);
+                        append_committed(store);
+                    } else {
+                        ColumnStore store(tbl_wal);
+                        store.attach_log(log, id);
+                        append_committed(store);
+                    }
+                });
+            }
+            for (auto &thread : threads)
+                thread.join();
+            auto t_append_end = steady_clock::now();
+
+            std::cout << "milestone1," << store2str[st]
+                      << (interval == WriteAheadLog::NO_GROUP_COMMIT ? ",wal_append," : ",wal_append_group,")
+                      << duration_cast<milliseconds>(t_append_end - t_append_begin).count() << '\n';
+        }
+        std::remove(filename.c_str());
+    }
+
+    /* Evaluate the latency of appends to a sorted column store, whose chunks are merged into the main on append or
+     * in the background. */
+    if (st == store_t::column) {
+        auto &tbl_merge = DB.add_table(C.pool("short_merge"));
+        tbl_merge.push_back(C.pool("id_a"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        tbl_merge.push_back(C.pool("id_b"),     m::Type::Get_Integer(m::Type::TY_Vector, 4));
+
+        using namespace std::chrono;
+
+        for (bool background : { false, true }) {
+            ColumnStore store(tbl_merge);
+            store.sort_by(1);
+            if (background)
+                store.merge_in_background();
+
+            constexpr std::size_t BATCH_SIZE = 1 << 10;
+            steady_clock::duration t_max(0);
+            auto t_write_begin = steady_clock::now();
+            for (int32_t i = 0; i != NUM_TUPLES_RW; ) {
+                const std::size_t n = std::min<std::size_t>(BATCH_SIZE, NUM_TUPLES_RW - i);
+                auto t_append_begin = steady_clock::now();
+                auto range = store.append(n);
+                for (std::size_t j = 0; j != n; ++j, ++i) {
+                    range.set(0, j, i);
+                    range.set(1, j, int32_t(int64_t(i) * 7919 % NUM_TUPLES_RW));
+                    range.set_null(0, j, false);
+                    range.set_null(1, j, false);
+                }
+                t_max = std::max(t_max, steady_clock::now() - t_append_begin);
+            }
+            store.merge();
+            auto t_write_end = steady_clock::now();
+
+            const std::string suffix = background ? "_background" : "";
+            std::cout << "milestone1," << store2str[st] << ",write_sorted" << suffix << ','
+                      << duration_cast<milliseconds>(t_write_end - t_write_begin).count() << '\n'
+                      << "milestone1," << store2str[st] << ",append_max_latency_us" << suffix << ','
+                      << duration_cast<microseconds>(t_max).count() << '\n';
+        }
     }
 }
 
@@ -124,4 +474,6 @@ int main()
 {
     benchmark_store(store_t::row);
     benchmark_store(store_t::column);
+    benchmark_store(store_t::pax);
+    benchmark_store(store_t::group);
 }
@@ -1,4 +1,6 @@
+#include "AdaptiveRadixTree.hpp"
 #include "BPlusTree.hpp"
+#include "HashIndex.hpp"
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
@@ -17,6 +19,8 @@ constexpr std::size_t NUM_TUPLES = 5e7;
 constexpr std::size_t NUM_POINT_LOOKUPS = 5e5;
 #endif
 
+constexpr double BLOOM_BITS_PER_KEY = 10;
+
 }
 
 std::size_t no_dead_code;
@@ -86,6 +90,8 @@ int main()
 {
     using std::begin, std::end;
     using btree_type = BPlusTree<int32_t, int32_t>;
+    using art_type = AdaptiveRadixTree<int32_t, int32_t>;
+    using hash_type = HashIndex<int32_t, int32_t>;
 
     std::mt19937 g(0);
 
@@ -126,21 +132,19 @@ int main()
 #undef PREPARE_KEYS
 
     /* Benchmark point lookups. */
-#define BENCH_LOOKUP_POINT(HIT, MISS) { \
+#define BENCH_LOOKUP_POINT(TREE, NAME, HIT, MISS) { \
     auto t_lookup_begin = steady_clock::now(); \
     for (auto k : keys_##HIT##_##MISS) { \
-        no_dead_code += tree.find(k) != tree.end(); \
+        no_dead_code += TREE.find(k) != TREE.end(); \
     } \
     auto t_lookup_end = steady_clock::now(); \
-    std::cout << "milestone2,lookup_point_" #HIT "_" #MISS "," \
+    std::cout << "milestone2," NAME "lookup_point_" #HIT "_" #MISS "," \
               << duration_cast<milliseconds>(t_lookup_end - t_lookup_begin).count() << '\n'; \
 }
 
-    BENCH_LOOKUP_POINT(10, 90);
-    BENCH_LOOKUP_POINT(50, 50);
-    BENCH_LOOKUP_POINT(90, 10);
-
-#undef BENCH_LOOKUP_POINT
+    BENCH_LOOKUP_POINT(tree, "", 10, 90);
+    BENCH_LOOKUP_POINT(tree, "", 50, 50);
+    BENCH_LOOKUP_POINT(tree, "", 90, 10);
 
     /* Benchmark range lookups. */
     std::vector<std::size_t> key_pos;
@@ -148,17 +152,87 @@ int main()
         key_pos.emplace_back(keys.size() / 100 * i);
     const std::size_t RANGE_WIDTH = NUM_TUPLES / 50; // 2%
 
-    auto t_lookup_begin = steady_clock::now();
+#define BENCH_LOOKUP_RANGE(TREE, NAME) { \
+    auto t_lookup_begin = steady_clock::now(); \
+    for (auto pos : key_pos) { \
+        assert(pos + RANGE_WIDTH < keys.size()); \
+        const auto k_lo = keys[pos]; \
+        const auto k_hi = keys[pos + RANGE_WIDTH]; \
+\
+        auto range = TREE.in_range(k_lo, k_hi); \
+        for (auto v : range) \
+            no_dead_code += v.first; \
+    } \
+    auto t_lookup_end = steady_clock::now(); \
+    std::cout << "milestone2," NAME "lookup_range," \
+              << duration_cast<milliseconds>(t_lookup_end - t_lookup_begin).count() << '\n'; \
+}
+
+    BENCH_LOOKUP_RANGE(tree, "");
+
+    /* Benchmark range lookups, consuming the range leaf by leaf. */
+    auto t_scan_begin = steady_clock::now();
     for (auto pos : key_pos) {
-        assert(pos + RANGE_WIDTH < keys.size());
         const auto k_lo = keys[pos];
         const auto k_hi = keys[pos + RANGE_WIDTH];
 
-        auto range = tree.in_range(k_lo, k_hi);
-        for (auto v : range)
-            no_dead_code += v.first;
+        tree.scan(k_lo, k_hi, [](const btree_type::chunk &c) {
+            std::size_t sum = 0;
+            for (std::size_t i = 0; i != c.size(); ++i)
+                sum += c.key(i);
+            no_dead_code += sum;
+        });
     }
-    auto t_lookup_end = steady_clock::now();
-    std::cout << "milestone2,lookup_range," << duration_cast<milliseconds>(t_lookup_end - t_lookup_begin).count()
+    auto t_scan_end = steady_clock::now();
+    std::cout << "milestone2,lookup_range_scan," << duration_cast<milliseconds>(t_scan_end - t_scan_begin).count()
               << '\n';
+
+    /* Evaluate the B+-tree with a Bloom filter in front of `find`. */
+    {
+        auto t_bulkload_begin = steady_clock::now();
+        auto filtered = btree_type::Bulkload(data, BLOOM_BITS_PER_KEY);
+        auto t_bulkload_end = steady_clock::now();
+        std::cout << "milestone2,bloom_bulkload,"
+                  << duration_cast<milliseconds>(t_bulkload_end - t_bulkload_begin).count() << '\n';
+
+        BENCH_LOOKUP_POINT(filtered, "bloom_", 10, 90);
+        BENCH_LOOKUP_POINT(filtered, "bloom_", 50, 50);
+        BENCH_LOOKUP_POINT(filtered, "bloom_", 90, 10);
+
+        /* Report the false-positive rate of the filter, in percent, on keys that are not in the tree. */
+        std::size_t num_false_positives = 0;
+        for (auto k : missing_keys)
+            num_false_positives += filtered.filter().may_contain(k);
+        std::cout << "milestone2,bloom_fpr," << 100.0 * num_false_positives / missing_keys.size() << '\n';
+    }
+
+    /* Evaluate the adaptive radix tree on the same data, to choose the index structure per column. */
+    {
+        auto t_bulkload_begin = steady_clock::now();
+        auto art = art_type::Bulkload(data);
+        auto t_bulkload_end = steady_clock::now();
+        std::cout << "milestone2,art_bulkload,"
+                  << duration_cast<milliseconds>(t_bulkload_end - t_bulkload_begin).count() << '\n';
+
+        BENCH_LOOKUP_POINT(art, "art_", 10, 90);
+        BENCH_LOOKUP_POINT(art, "art_", 50, 50);
+        BENCH_LOOKUP_POINT(art, "art_", 90, 10);
+        BENCH_LOOKUP_RANGE(art, "art_");
+    }
+
+    /* Evaluate the hash index for pure point lookup workloads. */
+    {
+        auto t_bulkload_begin = steady_clock::now();
+        auto index = hash_type::Bulkload(data);
+        auto t_bulkload_end = steady_clock::now();
+        std::cout << "milestone2,hash_bulkload,"
+                  << duration_cast<milliseconds>(t_bulkload_end - t_bulkload_begin).count() << '\n';
+
+        BENCH_LOOKUP_POINT(index, "hash_", 10, 90);
+        BENCH_LOOKUP_POINT(index, "hash_", 50, 50);
+        BENCH_LOOKUP_POINT(index, "hash_", 90, 10);
+    }
+
+#undef BENCH_LOOKUP_RANGE
+#undef BENCH_LOOKUP_POINT
 }
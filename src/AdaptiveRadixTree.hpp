@@ -0,0 +1,559 @@
+/*
+Header file for Adaptive Radix Tree (ART) implementation
+Refer Leis et al., "The Adaptive Radix Tree: ARTful Indexing for Main-Memory Databases", ICDE 2013
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * The ART offers the same surface as `BPlusTree` (`Bulkload`, `find`, `in_range` and iterators), but routes by the
+ * bytes of the key instead of comparing keys.  Only integral keys are supported.
+ * All entries are kept in a sorted array, in the order they were bulkloaded.  The radix tree maps every distinct key
+ * to the position of its first entry in that array, hence iterators are plain pointers into the array and a range is
+ * given by two lower bound searches in the tree.
+ */
+template<
+    typename Key,
+    typename Value>
+struct AdaptiveRadixTree
+{
+    static_assert(std::is_integral_v<Key>, "the adaptive radix tree only supports integral keys");
+
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+
+    private:
+    static constexpr size_type KEY_LENGTH = sizeof(key_type);
+
+    /* Binary comparable representation of a key: big endian with the sign bit flipped. */
+    struct key_bytes
+    {
+        uint8_t bytes[KEY_LENGTH];
+
+        key_bytes(key_type key) {
+            using unsigned_type = std::make_unsigned_t<key_type>;
+            unsigned_type k = static_cast<unsigned_type>(key);
+            if constexpr (std::is_signed_v<key_type>)
+                k ^= unsigned_type(1) << (8 * KEY_LENGTH - 1);
+            for (size_type i = 0; i != KEY_LENGTH; ++i)
+                bytes[i] = uint8_t(k >> (8 * (KEY_LENGTH - 1 - i)));
+        }
+
+        uint8_t operator[](size_type i) const { return bytes[i]; }
+    };
+
+    /*--- Tree Node Data Types ---------------------------------------------------------------------------------------*/
+    enum node_kind : uint8_t { LEAF, NODE4, NODE16, NODE48, NODE256 };
+
+    //Base node type inherited by all inner nodes and the leaf
+    struct node {
+        node_kind kind;
+        uint8_t prefix_len; ///< length of the compressed path
+        uint16_t num_children;
+        uint8_t prefix[KEY_LENGTH]; ///< the compressed path, keys are short enough to always store it completely
+
+        node(node_kind k) : kind(k), prefix_len(0), num_children(0) { }
+    };
+
+    /** A leaf stores a distinct key and the position of its first entry. */
+    struct leaf : node
+    {
+        key_type key;
+        size_type index;
+
+        leaf(key_type k, size_type i) : node(LEAF), key(k), index(i) { }
+    };
+
+    /** Node4 and Node16 store up to N sorted key bytes with their children in two parallel arrays. */
+    template<node_kind K, size_type N>
+    struct small_node : node
+    {
+        static constexpr size_type CAPACITY = N;
+        uint8_t keys[N];
+        node *children[N];
+
+        small_node() : node(K) { }
+    };
+    using node4 = small_node<NODE4, 4>;
+    using node16 = small_node<NODE16, 16>;
+
+    /** Node48 maps a key byte to one of 48 child slots via a 256 entry index. */
+    struct node48 : node
+    {
+        static constexpr uint8_t EMPTY = 48;
+        static constexpr size_type CAPACITY = 48;
+        uint8_t child_index[256];
+        node *children[48];
+
+        node48() : node(NODE48) { std::memset(child_index, EMPTY, sizeof(child_index)); }
+    };
+
+    /** Node256 directly stores a child pointer for every key byte. */
+    struct node256 : node
+    {
+        static constexpr size_type CAPACITY = 256;
+        node *children[256];
+
+        node256() : node(NODE256) { std::memset(children, 0, sizeof(children)); }
+    };
+
+    /*
+     * Declare fields of the ART.
+     */
+    std::vector<value_type> entries; ///< all entries, sorted by key
+    node *root;
+    size_type height_of_tree;
+
+    /*--- Range Type -------------------------------------------------------------------------------------------------*/
+    template<typename It>
+    struct the_range
+    {
+        private:
+        It begin_;
+        It end_;
+
+        public:
+        the_range(It begin, It end) : begin_(begin), end_(end) { assert(begin_ <= end_); }
+
+        It begin() const { return begin_; }
+        It end() const { return end_; }
+
+        bool empty() const { return begin_ == end_; }
+    };
+    public:
+    using range = the_range<iterator>;
+    using const_range = the_range<const_iterator>;
+
+    /*--- Node Operations --------------------------------------------------------------------------------------------*/
+    private:
+    static void destroy(node *n) {
+        if (n == nullptr) return;
+        switch (n->kind) {
+            case LEAF:
+                delete static_cast<leaf*>(n);
+                return;
+            case NODE4: {
+                node4 *in = static_cast<node4*>(n);
+                for (size_type i = 0; i != in->num_children; ++i) destroy(in->children[i]);
+                delete in;
+                return;
+            }
+            case NODE16: {
+                node16 *in = static_cast<node16*>(n);
+                for (size_type i = 0; i != in->num_children; ++i) destroy(in->children[i]);
+                delete in;
+                return;
+            }
+            case NODE48: {
+                node48 *in = static_cast<node48*>(n);
+                for (size_type i = 0; i != in->num_children; ++i) destroy(in->children[i]);
+                delete in;
+                return;
+            }
+            case NODE256: {
+                node256 *in = static_cast<node256*>(n);
+                for (node *c : in->children) destroy(c);
+                delete in;
+                return;
+            }
+        }
+    }
+
+    /** Returns the position of `byte` in the sorted key array of a Node4/Node16, or `num_children` if absent. */
+    template<typename N>
+    static size_type find_byte(const N *n, uint8_t byte) {
+#ifdef __SSE2__
+        if constexpr (N::CAPACITY == 16) {
+            const __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(char(byte)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+            const unsigned mask = unsigned(_mm_movemask_epi8(cmp)) & ((1U << n->num_children) - 1);
+            return mask ? __builtin_ctz(mask) : n->num_children;
+        }
+#endif
+        for (size_type i = 0; i != n->num_children; ++i)
+            if (n->keys[i] == byte) return i;
+        return n->num_children;
+    }
+
+    /** Returns a pointer to the child slot for `byte`, or `nullptr` if `n` has no such child. */
+    static node ** find_child(node *n, uint8_t byte) {
+        switch (n->kind) {
+            case NODE4: {
+                node4 *in = static_cast<node4*>(n);
+                size_type i = find_byte(in, byte);
+                return i != in->num_children ? &in->children[i] : nullptr;
+            }
+            case NODE16: {
+                node16 *in = static_cast<node16*>(n);
+                size_type i = find_byte(in, byte);
+                return i != in->num_children ? &in->children[i] : nullptr;
+            }
+            case NODE48: {
+                node48 *in = static_cast<node48*>(n);
+                return in->child_index[byte] != node48::EMPTY ? &in->children[in->child_index[byte]] : nullptr;
+            }
+            case NODE256: {
+                node256 *in = static_cast<node256*>(n);
+                return in->children[byte] ? &in->children[byte] : nullptr;
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    /** Copies header and children of `from` into the larger node `to`. */
+    template<typename Small, typename Large>
+    static void copy_small(const Small *from, Large *to) {
+        to->prefix_len = from->prefix_len;
+        std::memcpy(to->prefix, from->prefix, KEY_LENGTH);
+        to->num_children = from->num_children;
+        if constexpr (Large::CAPACITY == 48) {
+            for (size_type i = 0; i != from->num_children; ++i) {
+                to->child_index[from->keys[i]] = uint8_t(i);
+                to->children[i] = from->children[i];
+            }
+        } else {
+            std::memcpy(to->keys, from->keys, from->num_children);
+            std::memcpy(to->children, from->children, from->num_children * sizeof(node*));
+        }
+    }
+
+    /** Adds `child` for `byte` to `ref`, growing the node to the next larger kind if it is full. */
+    static void add_child(node *&ref, uint8_t byte, node *child) {
+        switch (ref->kind) {
+            case NODE4:
+                add_child_small(static_cast<node4*>(ref), byte, child, ref);
+                return;
+            case NODE16:
+                add_child_small(static_cast<node16*>(ref), byte, child, ref);
+                return;
+            case NODE48: {
+                node48 *in = static_cast<node48*>(ref);
+                if (in->num_children == node48::CAPACITY) {
+                    node256 *grown = new node256();
+                    grown->prefix_len = in->prefix_len;
+                    std::memcpy(grown->prefix, in->prefix, KEY_LENGTH);
+                    grown->num_children = in->num_children;
+                    for (size_type b = 0; b != 256; ++b)
+                        if (in->child_index[b] != node48::EMPTY)
+                            grown->children[b] = in->children[in->child_index[b]];
+                    delete in;
+                    ref = grown;
+                    add_child(ref, byte, child);
+                    return;
+                }
+                in->child_index[byte] = uint8_t(in->num_children);
+                in->children[in->num_children++] = child;
+                return;
+            }
+            case NODE256: {
+                node256 *in = static_cast<node256*>(ref);
+                in->children[byte] = child;
+                in->num_children++;
+                return;
+            }
+            default:
+                assert(false and "cannot add a child to a leaf");
+        }
+    }
+
+    template<typename N>
+    static void add_child_small(N *in, uint8_t byte, node *child, node *&ref) {
+        if (in->num_children == N::CAPACITY) {
+            using grown_type = std::conditional_t<N::CAPACITY == 4, node16, node48>;
+            grown_type *grown = new grown_type();
+            copy_small(in, grown);
+            delete in;
+            ref = grown;
+            add_child(ref, byte, child);
+            return;
+        }
+        /* keep the key bytes sorted */
+        size_type pos = 0;
+        while (pos != in->num_children and in->keys[pos] < byte) ++pos;
+        std::memmove(in->keys + pos + 1, in->keys + pos, in->num_children - pos);
+        std::memmove(in->children + pos + 1, in->children + pos, (in->num_children - pos) * sizeof(node*));
+        in->keys[pos] = byte;
+        in->children[pos] = child;
+        in->num_children++;
+    }
+
+    /** Inserts the leaf `l` with key bytes `kb` into the subtree `ref`, whose first `depth` bytes are consumed. */
+    static void insert(node *&ref, const key_bytes &kb, size_type depth, leaf *l) {
+        if (ref == nullptr) {
+            ref = l;
+            return;
+        }
+
+        if (ref->kind == LEAF) {
+            /* lazy expansion: replace the leaf by a Node4 that holds the common path of both keys */
+            leaf *other = static_cast<leaf*>(ref);
+            const key_bytes ob(other->key);
+            size_type p = 0;
+            while (depth + p < KEY_LENGTH and ob[depth + p] == kb[depth + p]) ++p;
+            assert(depth + p < KEY_LENGTH and "duplicate keys are not inserted into the radix tree");
+
+            node4 *n = new node4();
+            n->prefix_len = uint8_t(p);
+            std::memcpy(n->prefix, kb.bytes + depth, p);
+            node *nn = n;
+            add_child(nn, ob[depth + p], other);
+            add_child(nn, kb[depth + p], l);
+            ref = nn;
+            return;
+        }
+
+        /* path compression: split the compressed path at the first mismatch */
+        size_type p = 0;
+        while (p < ref->prefix_len and ref->prefix[p] == kb[depth + p]) ++p;
+        if (p < ref->prefix_len) {
+            node4 *n = new node4();
+            n->prefix_len = uint8_t(p);
+            std::memcpy(n->prefix, ref->prefix, p);
+            node *nn = n;
+            const uint8_t split_byte = ref->prefix[p];
+            ref->prefix_len -= uint8_t(p + 1);
+            std::memmove(ref->prefix, ref->prefix + p + 1, ref->prefix_len);
+            add_child(nn, split_byte, ref);
+            add_child(nn, kb[depth + p], l);
+            ref = nn;
+            return;
+        }
+
+        depth += ref->prefix_len;
+        node **child = find_child(ref, kb[depth]);
+        if (child)
+            insert(*child, kb, depth + 1, l);
+        else
+            add_child(ref, kb[depth], l);
+    }
+
+    /** Returns the leaf with the smallest key in the subtree `n`. */
+    static const leaf * minimum(const node *n) {
+        while (n->kind != LEAF) {
+            switch (n->kind) {
+                case NODE4:
+                    n = static_cast<const node4*>(n)->children[0];
+                    break;
+                case NODE16:
+                    n = static_cast<const node16*>(n)->children[0];
+                    break;
+                case NODE48: {
+                    const node48 *in = static_cast<const node48*>(n);
+                    size_type b = 0;
+                    while (in->child_index[b] == node48::EMPTY) ++b;
+                    n = in->children[in->child_index[b]];
+                    break;
+                }
+                case NODE256: {
+                    const node256 *in = static_cast<const node256*>(n);
+                    size_type b = 0;
+                    while (in->children[b] == nullptr) ++b;
+                    n = in->children[b];
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        return static_cast<const leaf*>(n);
+    }
+
+    /** Returns the leaf with the smallest key not less than `key` in the subtree `n`, or `nullptr`. */
+    static const leaf * lower_bound(const node *n, key_type key, const key_bytes &kb, size_type depth) {
+        if (n->kind == LEAF) {
+            const leaf *l = static_cast<const leaf*>(n);
+            return l->key >= key ? l : nullptr;
+        }
+
+        for (size_type i = 0; i != n->prefix_len; ++i) {
+            if (n->prefix[i] < kb[depth + i]) return nullptr; // all keys of the subtree are smaller
+            if (n->prefix[i] > kb[depth + i]) return minimum(n); // all keys of the subtree are greater
+        }
+        depth += n->prefix_len;
+        const uint8_t byte = kb[depth];
+
+        /* Descend into the child for `byte`; if that yields nothing, the answer is the minimum of the next child. */
+        switch (n->kind) {
+            case NODE4:
+            case NODE16: {
+                const uint8_t *keys = n->kind == NODE4 ? static_cast<const node4*>(n)->keys
+                                                       : static_cast<const node16*>(n)->keys;
+                node * const *children = n->kind == NODE4 ? static_cast<const node4*>(n)->children
+                                                          : static_cast<const node16*>(n)->children;
+                for (size_type i = 0; i != n->num_children; ++i) {
+                    if (keys[i] == byte) {
+                        if (auto l = lower_bound(children[i], key, kb, depth + 1)) return l;
+                    } else if (keys[i] > byte) {
+                        return minimum(children[i]);
+                    }
+                }
+                return nullptr;
+            }
+            case NODE48: {
+                const node48 *in = static_cast<const node48*>(n);
+                if (in->child_index[byte] != node48::EMPTY)
+                    if (auto l = lower_bound(in->children[in->child_index[byte]], key, kb, depth + 1)) return l;
+                for (size_type b = size_type(byte) + 1; b < 256; ++b)
+                    if (in->child_index[b] != node48::EMPTY) return minimum(in->children[in->child_index[b]]);
+                return nullptr;
+            }
+            case NODE256: {
+                const node256 *in = static_cast<const node256*>(n);
+                if (in->children[byte])
+                    if (auto l = lower_bound(in->children[byte], key, kb, depth + 1)) return l;
+                for (size_type b = size_type(byte) + 1; b < 256; ++b)
+                    if (in->children[b]) return minimum(in->children[b]);
+                return nullptr;
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    static size_type compute_height(const node *n) {
+        size_type h = 0;
+        switch (n->kind) {
+            case LEAF:
+                return 0;
+            case NODE4:
+                for (size_type i = 0; i != n->num_children; ++i)
+                    h = std::max(h, compute_height(static_cast<const node4*>(n)->children[i]));
+                break;
+            case NODE16:
+                for (size_type i = 0; i != n->num_children; ++i)
+                    h = std::max(h, compute_height(static_cast<const node16*>(n)->children[i]));
+                break;
+            case NODE48:
+                for (size_type i = 0; i != n->num_children; ++i)
+                    h = std::max(h, compute_height(static_cast<const node48*>(n)->children[i]));
+                break;
+            case NODE256:
+                for (const node *c : static_cast<const node256*>(n)->children)
+                    if (c) h = std::max(h, compute_height(c));
+                break;
+        }
+        return h + 1;
+    }
+
+    /** Returns the position of the first entry with a key not less than `key`. */
+    size_type lower_bound_index(const key_type key) const {
+        if (root == nullptr) return entries.size();
+        const leaf *l = lower_bound(root, key, key_bytes(key), 0);
+        return l ? l->index : entries.size();
+    }
+
+    /*--- Start of ART code ------------------------------------------------------------------------------------------*/
+    public:
+    /** Bulkloads the entries in [`begin`, `end`).  As for `BPlusTree`, the entries must be sorted by key. */
+    template<typename It>
+    static AdaptiveRadixTree Bulkload(It begin, It end) {
+        AdaptiveRadixTree tree;
+        for (auto i = begin; i != end; ++i)
+            tree.entries.emplace_back(i->first, i->second);
+
+        for (size_type i = 0; i != tree.entries.size(); ++i) {
+            const key_type key = tree.entries[i].first;
+            if (i != 0 and tree.entries[i - 1].first == key) continue; // only the first entry of a key is indexed
+            insert(tree.root, key_bytes(key), 0, new leaf(key, i));
+        }
+        tree.height_of_tree = tree.root ? compute_height(tree.root) : 0;
+        return tree;
+    }
+
+    template<typename Container>
+    static AdaptiveRadixTree Bulkload(const Container &C) {
+        using std::begin, std::end;
+        return Bulkload(begin(C), end(C));
+    }
+
+    AdaptiveRadixTree() : root(nullptr), height_of_tree(0) { }
+
+    AdaptiveRadixTree(const AdaptiveRadixTree&) = delete;
+    AdaptiveRadixTree(AdaptiveRadixTree &&other)
+        : entries(std::move(other.entries))
+        , root(std::exchange(other.root, nullptr))
+        , height_of_tree(std::exchange(other.height_of_tree, 0))
+    { }
+
+    ~AdaptiveRadixTree() {
+        //recursively free all nodes
+        destroy(root);
+    }
+
+    /** Returns the number of entries. */
+    size_type size() const { return entries.size(); }
+    /** Returns the height of the tree, i.e. the number of inner nodes on the longest path from root to leaf. */
+    size_type height() const { return height_of_tree; }
+
+    /** Returns an iterator to the first entry. */
+    iterator begin() { return entries.data(); }
+    /** Returns an iterator to the entry following the last entry. */
+    iterator end() { return entries.data() + entries.size(); }
+    /** Returns an iterator to the first entry. */
+    const_iterator begin() const { return entries.data(); }
+    /** Returns an iterator to the entry following the last entry. */
+    const_iterator end() const { return entries.data() + entries.size(); }
+    /** Returns an iterator to the first entry. */
+    const_iterator cbegin() const { return entries.data(); }
+    /** Returns an iterator to the entry following the last entry. */
+    const_iterator cend() const { return entries.data() + entries.size(); }
+
+    /** Returns an iterator to the first entry with a key that equals `key`, or `end()` if no such entry exists. */
+    const_iterator find(const key_type key) const {
+        const node *n = root;
+        if (n == nullptr) return cend();
+
+        const key_bytes kb(key);
+        size_type depth = 0;
+        while (n->kind != LEAF) {
+            if (std::memcmp(n->prefix, kb.bytes + depth, n->prefix_len) != 0) return cend();
+            depth += n->prefix_len;
+            node **child = find_child(const_cast<node*>(n), kb[depth]);
+            if (child == nullptr) return cend();
+            n = *child;
+            ++depth;
+        }
+
+        const leaf *l = static_cast<const leaf*>(n);
+        return l->key == key ? cbegin() + l->index : cend();
+    }
+
+    /** Returns an iterator to the first entry with a key that equals `key`, or `end()` if no such entry exists. */
+    iterator find(const key_type key) {
+        return begin() + (static_cast<const AdaptiveRadixTree*>(this)->find(key) - cbegin());
+    }
+
+    /** Returns the range of entries between `lower` (including) and `upper` (excluding). */
+    const_range in_range(const key_type &lower, const key_type &upper) const {
+        if (not (lower < upper)) return const_range(cend(), cend());
+        return const_range(cbegin() + lower_bound_index(lower), cbegin() + lower_bound_index(upper));
+    }
+
+    /** Returns the range of entries between `lower` (including) and `upper` (excluding). */
+    range in_range(const key_type &lower, const key_type &upper) {
+        if (not (lower < upper)) return range(end(), end());
+        return range(begin() + lower_bound_index(lower), begin() + lower_bound_index(upper));
+    }
+};
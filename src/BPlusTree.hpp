@@ -4,6 +4,7 @@ Header file for B+ Tree implementation
 
 #pragma once
 
+#include "BloomFilter.hpp"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -65,6 +66,7 @@ struct BPlusTree
     leaf_node *first_leaf, *last_leaf;
     entry_type *first_entry, *last_entry;
     node *root;
+    BloomFilter<key_type> membership_filter; ///< consulted by `find` before descending, disabled by default
 
     /*--- Iterator ---------------------------------------------------------------------------------------------------*/
     private:
@@ -222,6 +224,41 @@ struct BPlusTree
     using range = the_range<false>;
     using const_range = the_range<true>;
 
+    /*--- Leaf Chunk -------------------------------------------------------------------------------------------------*/
+    /** A contiguous run of entries inside a single leaf.  Chunks are handed out by `scan()`, one per leaf, and are
+     * clipped to the bounds of the scanned range.  Keys and values are interleaved, hence `key(i)` and `value(i)` are
+     * strided by `sizeof(value_type)`. */
+    struct chunk
+    {
+        const_pointer entries; ///< the first entry of the chunk
+        size_type count; ///< the number of entries in the chunk
+
+        const_pointer begin() const { return entries; }
+        const_pointer end() const { return entries + count; }
+        size_type size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        const key_type & key(size_type i) const { return entries[i].first; }
+        const mapped_type & value(size_type i) const { return entries[i].second; }
+    };
+
+
+    /** Inner nodes with at most this many children are routed by a linear scan instead of a binary search. */
+    static constexpr size_type LINEAR_ROUTING_CAPACITY = 16;
+
+    /** Returns the number of keys in the sorted array `keys` of length `n` that are less than `key`.  The loop has a
+     * fixed trip count for a given `n` and the comparison result selects the next base without a branch. */
+    static size_type branchless_lower_bound(const key_type *keys, size_type n, const key_type &key) {
+        if (n == 0) return 0;
+        key_compare less;
+        const key_type *base = keys;
+        while (n > 1) {
+            size_type half = n / 2;
+            base = less(base[half - 1], key) ? base + half : base;
+            n -= half;
+        }
+        return (base - keys) + less(*base, key);
+    }
 
     /** Implements an inner node in a B+-Tree.  An inner node stores k-1 keys that distinguish the k child pointers. */
     struct inner_node : node
@@ -333,6 +370,29 @@ struct BPlusTree
         bool full() const {
             return filled_entries == COMPUTE_CAPACITY();
         }
+
+        /*
+         * Routing primitive shared by all lookups.  Returns the index of the child to descend into for `key`, which is
+         * the number of keys in this node that are less than `key` (a lower bound).  With more than one child, key i is
+         * the smallest key of child i+1.  Entries equal to that key may also end child i, hence a key equal to a
+         * separator is routed to the left child and the lookup continues along the ISAM if necessary.
+         * Small nodes count with a linear scan that the compiler vectorizes, larger nodes use a branchless binary
+         * search.  The choice is made at compile time from the node capacity.
+         */
+        size_type route(const key_type &key) const {
+            const size_type num_keys = filled_entries > 0 ? filled_entries - 1 : 0;
+            key_compare less;
+            if constexpr (COMPUTE_CAPACITY() <= LINEAR_ROUTING_CAPACITY) {
+                size_type index = 0;
+                for (size_type i = 0; i < num_keys; i++) {
+                    index += less(keys[i], key);
+                }
+                return index;
+            }
+            else {
+                return branchless_lower_bound(keys, num_keys, key);
+            }
+        }
     };
 
     /** Implements a leaf node in a B+-Tree.  A leaf node stores key-value-pairs.  */
@@ -393,7 +453,7 @@ struct BPlusTree
         }
 
         /** Returns true iff the leaf is full, i.e. the capacity is reached. */
-        bool full() const {/
+        bool full() const {
             return filled_entries == COMPUTE_CAPACITY();
         }
         /** Returns a pointer to the next leaf node in the ISAM or `nullptr` if there is no next leaf node. */
@@ -425,7 +485,7 @@ struct BPlusTree
         }
         /** Returns an iterator to the entry following the last entry in the leaf. */
         const entry_type * end() const {
-            const auto p = entries + COMPUTE_CAPACITY();
+            const auto p = entries + filled_entries;
             return p;
         }
         /** Returns an iterator to the first entry in the leaf. */
@@ -435,7 +495,7 @@ struct BPlusTree
         }
         /** Returns an iterator to the entry following the last entry in the leaf. */
         const entry_type * cend() const {
-            const auto p = entries + COMPUTE_CAPACITY();
+            const auto p = entries + filled_entries;
             return p;
         }
     };
@@ -474,9 +534,12 @@ struct BPlusTree
         std::cout << "\n";
     }
     
-    //simplified bulkloading
+    /*
+     * Simplified bulkloading.  If `bits_per_key` is positive, a Bloom filter with that many bits per key is built
+     * alongside the tree, and `find` answers most lookups of missing keys from the filter.
+     */
     template<typename It>
-    static BPlusTree Bulkload(It begin, It end) {
+    static BPlusTree Bulkload(It begin, It end, double bits_per_key = 0) {
         // push pairs into a vector
         size_type num_entries = 0;
         leaf_node *first_leaf, *last_leaf;
@@ -488,11 +551,21 @@ struct BPlusTree
             data.push_back(*i);
         }  
         num_entries = data.size();
+
+        //build the membership filter over all distinct keys, the data is sorted so duplicates are adjacent
+        size_type num_keys = 0;
+        for (size_type i = 0; i < num_entries; i++) {
+            num_keys += (i == 0 || data[i-1].first != data[i].first);
+        }
+        BloomFilter<key_type> filter(num_keys, bits_per_key);
+        for (auto &entry : data) {
+            filter.insert(entry.first);
+        }
         
         //0 entries => no BPlusTree
         if(num_entries == 0) {
             leaf_node *lf = new leaf_node();
-            return BPlusTree(lf, num_entries, height, lf, lf);
+            return BPlusTree(lf, num_entries, height, lf, lf, std::move(filter));
         }
 
 
@@ -516,7 +589,7 @@ struct BPlusTree
         last_leaf = current_leaf;
 
          if(num_leaves == 1) {
-            return BPlusTree(first_leaf, num_entries, height, first_leaf, first_leaf);
+            return BPlusTree(first_leaf, num_entries, height, first_leaf, first_leaf, std::move(filter));
         }
 
         do {
@@ -540,13 +613,13 @@ struct BPlusTree
         inner_node *root = static_cast<inner_node*>(all_nodes1.front());
         height++;
 
-        return BPlusTree(root, num_entries, height, first_leaf, last_leaf);
+        return BPlusTree(root, num_entries, height, first_leaf, last_leaf, std::move(filter));
     }
 
     template<typename Container>
-    static BPlusTree Bulkload(const Container &C) {
+    static BPlusTree Bulkload(const Container &C, double bits_per_key = 0) {
         using std::begin, std::end;
-        return Bulkload(begin(C), end(C));
+        return Bulkload(begin(C), end(C), bits_per_key);
     }
 
 
@@ -560,7 +633,8 @@ struct BPlusTree
     }
 
     BPlusTree(node* tree_root, size_type ne, size_type height, \
-    leaf_node *leaf_begin, leaf_node *leaf_end) {
+    leaf_node *leaf_begin, leaf_node *leaf_end, BloomFilter<key_type> filter = BloomFilter<key_type>())
+        : membership_filter(std::move(filter)) {
         root = tree_root;
         num_entries = ne;
         height_of_tree = height;
@@ -635,6 +709,10 @@ struct BPlusTree
     size_type height() const {
         return height_of_tree;
     }
+    /** Returns the membership filter consulted by `find`. */
+    const BloomFilter<key_type> & filter() const {
+        return membership_filter;
+    }
 
     /** Returns an iterator to the first entry in the tree. */
     iterator begin() {
@@ -702,105 +780,40 @@ struct BPlusTree
     /** Returns an iterator to the first entry with a key that equals `key`, or `end()` if no such entry exists. */
     const_iterator find(const key_type key) const {
         if (num_entries < 1) return cend();
+        if (not membership_filter.may_contain(key)) return cend();
 
-        // go through nodes to search key
-        node* currentNode = root; 
-        while(currentNode->is_leaf == '0') {
-            inner_node* innerNode = reinterpret_cast<inner_node*>(currentNode);
-            size_type index = 0;
-            bool found = false;
-            for(index = 0; index < innerNode->size()-1; index++) {
-                if (key < innerNode->getKey(index)) {
-                    found = true;
-                    break; 
-                }
-            }
-            if(!innerNode->full() && !found) {
-                index++;
-            }
-            if(index < innerNode->size()) {
-                currentNode = innerNode->getChild(index);
-            }
-            else {
-                return cend();
-            }
+        auto [leaf, entry] = lower_bound(key);
+        if (entry == leaf->end() || key_compare{}(key, entry->first)) {
+            // found no entry that equals 'key'
+            return cend();
         }
-
-        // go through leaf and search the key
-        leaf_node* leaf = static_cast<leaf_node*>(currentNode);
-        for (auto entry = leaf->begin(); entry != leaf->end(); entry++) {
-            if (entry->first == key) {
-                // entry *i equals 'key'
-                return iterator(leaf, entry);
-            }
-        }
-
-        // found no entry that equals 'key'
-        return cend();
+        return const_iterator(leaf, entry);
     }
 
     /** Returns an iterator to the first entry with a key that equals `key`, or `end()` if no such entry exists. */
     iterator find(const key_type &key) {
         if (num_entries < 1) return end();
+        if (not membership_filter.may_contain(key)) return end();
 
-        // go through nodes to search key
-        node* currentNode = root; 
-        while(currentNode->is_leaf == '0') {
-            inner_node* innerNode = reinterpret_cast<inner_node*>(currentNode);
-            size_type index = 0;
-            bool found = false;
-            /*
-            The range support is [k1, k2), hence we check for key < k2
-            */
-            for(index = 0; index < innerNode->size()-1; index++) {
-                if (key < innerNode->getKey(index)) {
-                    found = true;
-                    break; 
-                }
-            }
-            if(!innerNode->full() && !found) {
-                index = innerNode->size()-1;
-            }
-            if(index < innerNode->size()) {
-                currentNode = innerNode->getChild(index);
-            }
-            else {
-                return end();
-            }
+        auto [leaf, entry] = lower_bound(key);
+        if (entry == leaf->end() || key_compare{}(key, entry->first)) {
+            // found no entry that equals 'key'
+            return end();
         }
-
-        // go through leaf and search the key
-        leaf_node* leaf = static_cast<leaf_node*>(currentNode);
-        for (auto entry = leaf->begin(); entry != leaf->end(); entry++) {
-            if (entry->first == key) {
-                // entry *i equals 'key'
-                return iterator(leaf, entry);
-            }
-        }
-
-        // found no entry that equals 'key'
-        return end();
+        return iterator(leaf, entry);
     }
 
     /** Returns the range of entries between `lower` (including) and `upper` (excluding). */
     const_range in_range(const key_type &lower, const key_type &upper) const {
         if (num_entries < 1) {
-            return const_range(iterator(nullptr, nullptr), iterator(nullptr, nullptr));
+            return const_range(cend(), cend());
         }
 
-        the_iterator start = findLower(lower, root);
-        if((start == end()) || (start->first >= upper)) {
-            return const_range(iterator(nullptr, nullptr), iterator(nullptr, nullptr));
+        const_iterator start = findLower(lower);
+        if((start == cend()) || !key_compare{}(start->first, upper)) {
+            return const_range(cend(), cend());
         }
-
-        the_iterator fin = start;
-        while(!(fin == end())) {
-            if((fin->first) >= upper) {
-                break;
-            }
-            fin++;
-        }
-        return const_range(start, fin);
+        return const_range(start, findLower(upper));
     }
 
     /** Returns the range of entries between `lower` (including) and `upper` (excluding). */
@@ -809,52 +822,76 @@ struct BPlusTree
             return range(end(), end());
         }
 
-        iterator start = findLower(lower, root);
-        if((start == end()) || (start->first >= upper)) {
+        iterator start = findLower(lower);
+        if((start == end()) || !key_compare{}(start->first, upper)) {
             return range(end(), end());
         }
+        return range(start, findLower(upper));
+    }
 
-        iterator fin = start;
-        while(!(fin == end())) {
-            if((fin->first) >= upper) {
-                break;
+    //find element >= lower
+    iterator findLower(const key_type &lower) {
+        auto [leaf, entry] = lower_bound(lower);
+        return iterator(leaf, entry);
+    }
+
+    //find element >= lower
+    const_iterator findLower(const key_type &lower) const {
+        auto [leaf, entry] = lower_bound(lower);
+        return const_iterator(leaf, entry);
+    }
+
+    /** Calls `callback` with one `chunk` per leaf for all entries between `lower` (including) and `upper`
+     * (excluding).  Only the first and the last leaf of the range are clipped, all leaves in between are handed out
+     * as a whole, so consumers can process them without any per-entry branching. */
+    template<typename Callback>
+    void scan(const key_type &lower, const key_type &upper, Callback &&callback) {
+        if (num_entries < 1) return;
+
+        iterator start = findLower(lower);
+        if (start == end()) return;
+
+        auto key_less = [](const entry_type &e, const key_type &k) { return key_compare{}(e.first, k); };
+        leaf_node *leaf = start.node_;
+        entry_type *first = start.elem_;
+        while (leaf != nullptr) {
+            entry_type *last = leaf->end();
+            if (not key_compare{}((last - 1)->first, upper)) {
+                /* the range ends inside this leaf */
+                last = std::lower_bound(first, last, upper, key_less);
+                if (first != last)
+                    callback(chunk{ reinterpret_cast<const_pointer>(first), size_type(last - first) });
+                return;
             }
-            fin++;
+            callback(chunk{ reinterpret_cast<const_pointer>(first), size_type(last - first) });
+            leaf = leaf->next();
+            if (leaf != nullptr) first = leaf->begin();
         }
-        return range(start, fin);
     }
 
-    //find element >= lower
-    iterator findLower (const key_type &lower, node* root) {
-        // go through nodes to search keys in range
-        node* currentNode = root; 
+    private:
+    /*
+     * Descends from the root to the leaf that may hold the first entry not less than `key`, and returns that leaf and
+     * entry.  If all entries of that leaf are less than `key`, the answer is the first entry of the next leaf.  If
+     * there is no such entry, the returned entry is the end of the last leaf, which is where `end()` points.
+     */
+    std::pair<leaf_node*, entry_type*> lower_bound(const key_type &key) const {
+        node *currentNode = root;
         while(currentNode->is_leaf == '0') {
-            inner_node* innerNode = reinterpret_cast<inner_node*>(currentNode);
-            size_type index = 0;
-            bool found = false;
-    
-            for(index = 0; index < innerNode->size()-1; index++) {
-                if (lower < innerNode->getKey(index)) {
-                    found = true;
-                    break; 
-                }
-            }
-            if(!innerNode->full() && !found) {
-                index = innerNode->size()-1;
-            }
-            if(index < innerNode->size()) {
-                currentNode = innerNode->getChild(index);
-            }
+            inner_node *innerNode = static_cast<inner_node*>(currentNode);
+            currentNode = innerNode->getChild(innerNode->route(key));
         }
-        // go through leaf and search the key
-        leaf_node* leaf = static_cast<leaf_node*>(currentNode);
-        for (entry_type *i = leaf->begin(); i != leaf->end(); i++) {
-            entry_type entry = *i;
-            if (entry.first >= lower) {
-                return iterator(leaf, i);
-            }
+
+        leaf_node *leaf = static_cast<leaf_node*>(currentNode);
+        entry_type *entry = std::lower_bound(leaf->begin(), leaf->end(), key,
+                                             [](const entry_type &e, const key_type &k) {
+                                                 return key_compare{}(e.first, k);
+                                             });
+        if(entry == leaf->end() && leaf->next() != nullptr) {
+            leaf = leaf->next();
+            entry = leaf->begin();
         }
-        return end();
+        return { leaf, entry };
     }
 
 };
@@ -0,0 +1,264 @@
+/*
+Implementation of the block arena used as backing memory by the stores
+*/
+
+#include "BlockArena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+
+BlockArena::BlockArena(std::size_t block_size, std::size_t reservation, AllocationPolicy policy)
+    : block_size(block_size), committed(0), policy(policy), hugetlb(false), fd(-1), header(nullptr), header_size(0)
+{
+    //huge pages can only be committed as a whole
+    if(policy.huge_pages) {
+        this->block_size = (block_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+    //round the reservation up to whole blocks
+    reserved = (reservation + this->block_size - 1) / this->block_size * this->block_size;
+
+    //reserve address space only, no memory is committed before the first call to reserve()
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if(policy.huge_pages) {
+        //explicit huge pages, only available if the administrator configured a pool of them; the reservation sets
+        //none aside, reserve() takes them from the pool block by block
+        p = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_NORESERVE, -1, 0);
+        hugetlb = p != MAP_FAILED;
+    }
+#endif
+    if(p == MAP_FAILED && policy.huge_pages) {
+        //align the region to huge pages so that transparent huge pages can back whole blocks
+        p = mmap(nullptr, reserved + HUGE_PAGE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(p != MAP_FAILED) {
+            char *unaligned = static_cast<char*>(p);
+            char *aligned = reinterpret_cast<char*>(
+                (reinterpret_cast<uintptr_t>(unaligned) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+            if(aligned != unaligned) {
+                munmap(unaligned, aligned - unaligned);
+            }
+            munmap(aligned + reserved, HUGE_PAGE_SIZE - (aligned - unaligned));
+            p = aligned;
+        }
+    }
+    if(p == MAP_FAILED && !policy.huge_pages) {
+        p = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    if(p == MAP_FAILED) {
+        std::cout << "Error in reserving " << reserved << " bytes of address space" << "\n";
+        exit(1);
+    }
+    base = static_cast<char*>(p);
+
+    apply_policy(base, reserved);
+}
+
+BlockArena::BlockArena(const char *filename, std::size_t header_bytes, std::size_t block_size,
+                       std::size_t reservation)
+    : block_size(block_size), committed(0), hugetlb(false), header(nullptr)
+{
+    //the blocks must start at a page boundary of the file to be mapped
+    const std::size_t page_size = sysconf(_SC_PAGESIZE);
+    header_size = (header_bytes + page_size - 1) / page_size * page_size;
+    this->block_size = (block_size + page_size - 1) / page_size * page_size;
+    reserved = (reservation + this->block_size - 1) / this->block_size * this->block_size;
+
+    fd = open(filename, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if(fd == -1 || fstat(fd, &st) != 0) {
+        std::cout << "Error in opening file " << filename << "\n";
+        exit(1);
+    }
+
+    //map the header and reserve address space for the blocks; pages after the end of the file must not be touched,
+    //so the blocks are only made accessible once the file covers them
+    void *p = MAP_FAILED;
+    if(header_size > 0) {
+        if(std::size_t(st.st_size) < header_size) resize_file(header_size);
+        p = mmap(nullptr, header_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(p == MAP_FAILED) {
+            std::cout << "Error in mapping the header of file " << filename << "\n";
+            exit(1);
+        }
+        header = static_cast<char*>(p);
+    }
+    p = mmap(nullptr, reserved, PROT_NONE, MAP_SHARED | MAP_NORESERVE, fd, header_size);
+    if(p == MAP_FAILED) {
+        std::cout << "Error in reserving " << reserved << " bytes of address space for file " << filename << "\n";
+        exit(1);
+    }
+    base = static_cast<char*>(p);
+
+    //commit the blocks that are already in the file
+    if(std::size_t(st.st_size) > header_size) {
+        reserve(st.st_size - header_size);
+    }
+}
+
+//set huge page and NUMA hints for a range of the reservation, they take effect when pages are first touched
+void BlockArena::apply_policy(char *begin, std::size_t bytes)
+{
+#ifdef MADV_HUGEPAGE
+    if(policy.huge_pages && !hugetlb) {
+        madvise(begin, bytes, MADV_HUGEPAGE);
+    }
+#endif
+#if defined(__linux__) && defined(SYS_mbind)
+    //use the system call directly to not depend on libnuma; the constants are those of <numaif.h>
+    constexpr int MPOL_INTERLEAVE_ = 3, MPOL_LOCAL_ = 4;
+    if(policy.numa == AllocationPolicy::NUMA_INTERLEAVE) {
+        unsigned long all_nodes = ~0UL; //the kernel restricts the mask to the nodes that exist
+        syscall(SYS_mbind, begin, bytes, MPOL_INTERLEAVE_, &all_nodes, 8 * sizeof(all_nodes), 0);
+    }
+    else if(policy.numa == AllocationPolicy::NUMA_FIRST_TOUCH) {
+        syscall(SYS_mbind, begin, bytes, MPOL_LOCAL_, nullptr, 0, 0);
+    }
+#endif
+}
+
+BlockArena::BlockArena(BlockArena &&other)
+    : base(std::exchange(other.base, nullptr))
+    , block_size(other.block_size)
+    , reserved(std::exchange(other.reserved, 0))
+    , committed(std::exchange(other.committed, 0))
+    , policy(other.policy)
+    , hugetlb(other.hugetlb)
+    , fd(std::exchange(other.fd, -1))
+    , header(std::exchange(other.header, nullptr))
+    , header_size(other.header_size)
+{ }
+
+BlockArena::~BlockArena()
+{
+    //release committed blocks and the reservation at once
+    if(base != nullptr) {
+        munmap(base, reserved);
+    }
+    if(header != nullptr) {
+        munmap(header, header_size);
+    }
+    if(fd != -1) {
+        close(fd);
+    }
+}
+
+//set the length of the mapped file to the header and `bytes` bytes of blocks
+void BlockArena::resize_file(std::size_t bytes)
+{
+    if(ftruncate(fd, bytes) != 0) {
+        std::cout << "Error in resizing file to " << bytes << " bytes" << "\n";
+        exit(1);
+    }
+}
+
+void BlockArena::reserve(std::size_t bytes)
+{
+    if(bytes <= committed) {
+        return;
+    }
+    if(bytes > reserved) {
+        std::cout << "Error in growing arena beyond " << reserved << " bytes" << "\n";
+        exit(1);
+    }
+
+    //commit the missing blocks, the data in the blocks committed before stays in place
+    std::size_t new_committed = (bytes + block_size - 1) / block_size * block_size;
+    if(is_persistent()) {
+        resize_file(header_size + new_committed);
+    }
+#ifdef MAP_HUGETLB
+    if(hugetlb) {
+        //map the blocks anew without MAP_NORESERVE, so that the kernel sets aside huge pages for exactly these blocks
+        //now instead of raising SIGBUS on first touch; if the pool is exhausted, they get regular pages
+        void *p = mmap(base + committed, new_committed - committed, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_FIXED, -1, 0);
+        if(p == MAP_FAILED) {
+            p = mmap(base + committed, new_committed - committed, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if(p != MAP_FAILED) {
+                madvise(p, new_committed - committed, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        if(p == MAP_FAILED) {
+            std::cout << "Error in committing memory" << "\n";
+            exit(1);
+        }
+        //a new mapping does not inherit the NUMA policy of the reservation
+        apply_policy(base + committed, new_committed - committed);
+        committed = new_committed;
+        return;
+    }
+#endif
+    if(mprotect(base + committed, new_committed - committed, PROT_READ | PROT_WRITE) != 0) {
+        std::cout << "Error in committing memory" << "\n";
+        exit(1);
+    }
+    committed = new_committed;
+}
+
+void BlockArena::shrink(std::size_t bytes)
+{
+    std::size_t new_committed = (bytes + block_size - 1) / block_size * block_size;
+    if(new_committed >= committed) {
+        return;
+    }
+
+#ifdef MAP_HUGETLB
+    if(hugetlb) {
+        //MADV_DONTNEED fails on huge pages before Linux 5.18; mapping the range anew frees its pages and returns them
+        //to the pool
+        if(mmap(base + new_committed, committed - new_committed, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED) {
+            std::cout << "Error in releasing memory" << "\n";
+            exit(1);
+        }
+        committed = new_committed;
+        return;
+    }
+#endif
+    //drop the pages first so that the kernel frees them, then make the range inaccessible again
+    if(madvise(base + new_committed, committed - new_committed, MADV_DONTNEED) != 0 ||
+       mprotect(base + new_committed, committed - new_committed, PROT_NONE) != 0) {
+        std::cout << "Error in releasing memory" << "\n";
+        exit(1);
+    }
+    //truncating the file frees its blocks on disk and in the page cache
+    if(is_persistent()) {
+        resize_file(header_size + new_committed);
+    }
+    committed = new_committed;
+}
+
+bool BlockArena::trim(std::size_t used)
+{
+    if(used * SHRINK_THRESHOLD >= committed) {
+        return false;
+    }
+    std::size_t old_committed = committed;
+    shrink(std::max(2 * used, block_size));
+    return committed != old_committed;
+}
+
+void BlockArena::sync()
+{
+    if(!is_persistent()) {
+        return;
+    }
+    if((header != nullptr && msync(header, header_size, MS_SYNC) != 0) ||
+       (committed > 0 && msync(base, committed, MS_SYNC) != 0)) {
+        std::cout << "Error in writing arena back to its file" << "\n";
+        exit(1);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+
+
+/*
+ * Placement of the memory of an arena.  Both settings are hints: if the system does not support them, the arena falls
+ * back to regular pages and the default NUMA policy of the process.
+ */
+struct AllocationPolicy
+{
+    enum numa_placement {
+        NUMA_DEFAULT, ///< use the policy of the process
+        NUMA_FIRST_TOUCH, ///< place each page on the node of the thread that touches it first
+        NUMA_INTERLEAVE, ///< spread pages round-robin across all nodes
+    };
+
+    bool huge_pages = false; ///< back the arena with 2 MiB pages, blocks are rounded up to whole huge pages
+    numa_placement numa = NUMA_DEFAULT;
+};
+
+/*
+ * A growable memory region made of fixed-size blocks.
+ * The arena reserves a large range of virtual address space up front and commits it block by block as it grows.
+ * Growing never moves or copies data, so the address of the region stays valid for the lifetime of the arena and a
+ * store can describe its data with a single linearization that is created once.
+ * A persistent arena maps a file instead of anonymous memory: committed blocks are the contents of the file after a
+ * header of `header_bytes()` bytes, so the data outlives the process and is shared through the page cache.
+ */
+struct BlockArena
+{
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024; // 64 KiB
+    static constexpr std::size_t DEFAULT_RESERVATION = std::size_t(1) << 36; // 64 GiB of address space
+    static constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024; // 2 MiB
+
+    private:
+    char *base; //beginning of the reserved region
+    std::size_t block_size; //granularity in which memory is committed
+    std::size_t reserved; //bytes of reserved address space
+    std::size_t committed; //bytes committed so far, a multiple of block_size
+    AllocationPolicy policy;
+    bool hugetlb; //true iff the region reserves explicit huge pages (MAP_HUGETLB), which are set aside per block
+    int fd; //the mapped file of a persistent arena, -1 otherwise
+    char *header; //the mapped header of the file
+    std::size_t header_size; //bytes before the first block in the file, a multiple of the page size
+
+    void apply_policy(char *begin, std::size_t bytes);
+    void resize_file(std::size_t bytes);
+
+    public:
+    BlockArena(std::size_t block_size = DEFAULT_BLOCK_SIZE, std::size_t reservation = DEFAULT_RESERVATION,
+               AllocationPolicy policy = AllocationPolicy());
+    /** Creates a persistent arena in the file `filename`.  An existing file is opened with all of its blocks
+     * committed, a new file is created empty.  The file begins with a header of `header_bytes` bytes, rounded up to
+     * whole pages, that is kept for the owner of the arena.  The allocation policy does not apply to files. */
+    BlockArena(const char *filename, std::size_t header_bytes, std::size_t block_size = DEFAULT_BLOCK_SIZE,
+               std::size_t reservation = DEFAULT_RESERVATION);
+    ~BlockArena();
+
+    BlockArena(const BlockArena&) = delete;
+    BlockArena(BlockArena &&other);
+
+    /** Returns the address of the first byte of the region. */
+    char * data() const { return base; }
+    /** Returns the number of bytes that are committed and can be accessed. */
+    std::size_t size() const { return committed; }
+    /** Returns the number of bytes that can be committed at most. */
+    std::size_t capacity() const { return reserved; }
+    /** Returns the size of a block in bytes. */
+    std::size_t block_bytes() const { return block_size; }
+    /** Returns the number of committed blocks. */
+    std::size_t num_blocks() const { return committed / block_size; }
+    /** Returns the placement policy of the arena. */
+    const AllocationPolicy & allocation_policy() const { return policy; }
+    /** Returns true iff the region is backed by explicitly reserved huge pages. */
+    bool uses_hugetlb() const { return hugetlb; }
+    /** Returns true iff the arena maps a file. */
+    bool is_persistent() const { return fd != -1; }
+    /** Returns the header of the mapped file, or `nullptr` if the arena is not persistent. */
+    char * header_data() const { return header; }
+    /** Returns the number of bytes of the header of the mapped file. */
+    std::size_t header_bytes() const { return header_size; }
+
+    /** Commits blocks until at least `bytes` bytes are accessible.  Never shrinks the region. */
+    void reserve(std::size_t bytes);
+    /** Decommits the blocks after the first `bytes` bytes, rounded up to whole blocks, and returns their memory to the
+     * operating system.  The contents of these blocks are lost. */
+    void shrink(std::size_t bytes);
+    /** Shrinks the region to twice `used` bytes, but only once less than a quarter of the committed bytes is used.
+     * The gap between both factors keeps alternating appends and drops from committing and releasing the same blocks
+     * over and over.  At least one block stays committed.  Returns true iff blocks were released. */
+    bool trim(std::size_t used);
+    /** Writes the header and the committed blocks of a persistent arena back to its file and waits for completion. */
+    void sync();
+
+    /** Blocks are released once less than 1/SHRINK_THRESHOLD of the committed bytes is used. */
+    static constexpr std::size_t SHRINK_THRESHOLD = 4;
+};
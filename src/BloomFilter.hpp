@@ -0,0 +1,95 @@
+/*
+Header file for a blocked Bloom filter
+Refer Putze et al., "Cache-, Hash- and Space-Efficient Bloom Filters", WEA 2007
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+ * An approximate membership filter.  `may_contain` never reports false for an inserted key, but may report true for a
+ * key that was never inserted.  The filter is split into blocks of one cache line each, and all bits of a key are set
+ * in the same block, so a lookup touches a single cache line.
+ * A default constructed filter is disabled and reports every key as contained.
+ */
+template<typename Key>
+struct BloomFilter
+{
+    using key_type = Key;
+    using size_type = std::size_t;
+
+    private:
+    static constexpr size_type BLOCK_BITS = 512;
+    static constexpr size_type WORD_BITS = 64;
+
+    struct alignas(64) block
+    {
+        uint64_t words[BLOCK_BITS / WORD_BITS];
+    };
+
+    /*
+     * Declare fields of the filter.
+     */
+    std::vector<block> blocks;
+    unsigned num_hashes; ///< number of bits set per key
+
+    static uint64_t hash(key_type key) {
+        /* finalizer of MurmurHash3 */
+        uint64_t h = uint64_t(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /** Maps the high half of the hash to a block without a division. */
+    size_type block_of(uint64_t h) const { return size_type(((h >> 32) * blocks.size()) >> 32); }
+
+    public:
+    BloomFilter() : num_hashes(0) { }
+
+    /** Creates a filter for `num_keys` keys with `bits_per_key` bits per key.  `bits_per_key == 0` disables it. */
+    BloomFilter(size_type num_keys, double bits_per_key) : num_hashes(0) {
+        if (bits_per_key <= 0 or num_keys == 0) return;
+        const size_type num_bits = std::ceil(num_keys * bits_per_key);
+        blocks.resize((num_bits + BLOCK_BITS - 1) / BLOCK_BITS, block{});
+        /* the optimal number of hash functions is ln(2) * bits per key */
+        num_hashes = std::max(1L, std::min(16L, std::lround(bits_per_key * 0.69314718)));
+    }
+
+    /** Returns true iff the filter is in use. */
+    bool enabled() const { return not blocks.empty(); }
+    /** Returns the size of the filter in bytes. */
+    size_type size_in_bytes() const { return blocks.size() * sizeof(block); }
+
+    void insert(key_type key) {
+        if (not enabled()) return;
+        const uint64_t h = hash(key);
+        block &b = blocks[block_of(h)];
+        /* derive the bit positions inside the block by double hashing the low half of the hash */
+        uint32_t h1 = uint32_t(h), h2 = uint32_t(h >> 17) | 1;
+        for (unsigned i = 0; i != num_hashes; ++i, h1 += h2) {
+            const uint32_t bit = h1 % BLOCK_BITS;
+            b.words[bit / WORD_BITS] |= uint64_t(1) << (bit % WORD_BITS);
+        }
+    }
+
+    bool may_contain(key_type key) const {
+        if (not enabled()) return true;
+        const uint64_t h = hash(key);
+        const block &b = blocks[block_of(h)];
+        uint32_t h1 = uint32_t(h), h2 = uint32_t(h >> 17) | 1;
+        bool contained = true;
+        for (unsigned i = 0; i != num_hashes; ++i, h1 += h2) {
+            const uint32_t bit = h1 % BLOCK_BITS;
+            contained &= (b.words[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+        }
+        return contained;
+    }
+};
@@ -0,0 +1,507 @@
+/*
+Implementation of the parallel CSV loader
+*/
+
+#include "CSVLoader.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__PCLMUL__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+/* How a field is converted into the value of an attribute. */
+struct column
+{
+    enum kind_t { INTEGRAL, FLOATING, BOOLEAN, CHARACTERS } kind;
+    std::size_t size; //in bits, in characters for CHARACTERS
+};
+
+/** Describes the conversion of every attribute of `table` in `columns`.  Returns false and reports to `diag` if an
+ * attribute has a type that cannot be loaded. */
+bool describe(m::Diagnostic &diag, const char *filename, const m::Table &table, std::vector<column> &columns)
+{
+    columns.clear();
+    for(auto &attr : table) {
+        if(attr.type->is_boolean()) columns.push_back(column{ column::BOOLEAN, 1 });
+        else if(attr.type->is_integral()) columns.push_back(column{ column::INTEGRAL, attr.type->size() });
+        else if(attr.type->is_floating_point()) columns.push_back(column{ column::FLOATING, attr.type->size() });
+        else if(attr.type->is_character_sequence())
+            columns.push_back(column{ column::CHARACTERS, attr.type->size() / 8 });
+        else {
+            diag.e(m::Position(filename)) << "attribute " << attr.name << " has a type that cannot be loaded\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Returns a pointer to the first line break outside of a quoted field in [`p`, `end`), or `end`. */
+const char * find_line_break(const char *p, const char *end, bool inside_quotes)
+{
+    for(; p < end; p++) {
+        if(*p == '\\') p++; //skip the escaped character
+        else if(*p == '"') inside_quotes = !inside_quotes;
+        else if(*p == '\n' && !inside_quotes) return p;
+    }
+    return end;
+}
+
+/** Copies [`begin`, `end`) to `out`, resolving the escape sequences \x and "". */
+void unescape(const char *begin, const char *end, std::string &out)
+{
+    out.clear();
+    for(const char *c = begin; c < end; c++) {
+        if(c + 1 < end && (*c == '\\' || (*c == '"' && c[1] == '"'))) c++; //keep the second character only
+        out.push_back(*c);
+    }
+}
+
+/*
+ * Finds the structural characters of a CSV file 64 bytes at a time, in the spirit of simdjson's stage 1.
+ * Refer Langdale and Lemire, "Parsing Gigabytes of JSON per Second", VLDB Journal 2019
+ * For every block, the indexer computes bitmasks of the unescaped quotes, line breaks, and commas, and of the bytes
+ * inside quoted fields.  Escapes and quotes carry over from one block to the next.
+ */
+struct structural_indexer
+{
+    static constexpr std::size_t BLOCK_SIZE = 64;
+
+    const char *block; //beginning of the current block
+    const char *end; //end of the file, the bytes after it read as blanks
+    uint64_t escape_carry = 0; //1 iff the first byte of the next block is escaped
+    uint64_t inside_carry = 0; //all ones iff the next block starts inside a quoted field
+    uint64_t quotes, inside, line_breaks, commas; //masks of the current block
+
+    /** Returns the mask of the commas and line breaks outside of quoted fields in the current block. */
+    uint64_t separators() const { return (line_breaks | commas) & ~inside; }
+
+    structural_indexer(const char *begin, const char *end) : block(begin), end(end) { index(); }
+
+    /** Moves to the next block. */
+    void advance() { block += BLOCK_SIZE; index(); }
+
+    private:
+    /** Returns the mask of the bytes of `p` that equal `c`. */
+    static uint64_t match(const char *p, char c) {
+#if defined(__AVX2__)
+        const __m256i needle = _mm256_set1_epi8(c);
+        const uint64_t lo = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), needle)));
+        const uint64_t hi = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), needle)));
+        return lo | hi << 32;
+#elif defined(__SSE2__)
+        const __m128i needle = _mm_set1_epi8(c);
+        uint64_t mask = 0;
+        for(unsigned i = 0; i < 4; i++) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+            mask |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle)))) << (16 * i);
+        }
+        return mask;
+#else
+        uint64_t mask = 0;
+        for(unsigned i = 0; i < BLOCK_SIZE; i++) mask |= uint64_t(p[i] == c) << i;
+        return mask;
+#endif
+    }
+
+    /** Returns the mask of all bytes that are preceded by an odd number of quotes, counting the byte itself. */
+    static uint64_t prefix_xor(uint64_t quotes) {
+#if defined(__PCLMUL__)
+        //carry-less multiplication by all ones computes the prefix xor
+        const __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, quotes), _mm_set1_epi8(char(0xff)), 0);
+        return uint64_t(_mm_cvtsi128_si64(product));
+#else
+        for(unsigned shift = 1; shift < 64; shift *= 2) quotes ^= quotes << shift;
+        return quotes;
+#endif
+    }
+
+    /** Returns the mask of the bytes escaped by a backslash, given the mask of all backslashes. */
+    uint64_t escaped(uint64_t backslashes) {
+        //a backslash that is itself escaped does not escape
+        backslashes &= ~escape_carry;
+        const uint64_t follows_escape = backslashes << 1 | escape_carry;
+        //runs of backslashes starting on an odd position escape the even positions after them, and vice versa
+        constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+        const uint64_t odd_starts = backslashes & ~EVEN_BITS & ~follows_escape;
+        uint64_t even_starts;
+        escape_carry = __builtin_add_overflow(odd_starts, backslashes, &even_starts);
+        const uint64_t invert = even_starts << 1;
+        return (EVEN_BITS ^ invert) & follows_escape;
+    }
+
+    void index() {
+        const char *p = block;
+        char padded[BLOCK_SIZE];
+        if(end - block < std::ptrdiff_t(BLOCK_SIZE)) {
+            //copy the last bytes of the file so that loads do not read past it
+            std::memset(padded, ' ', BLOCK_SIZE);
+            if(end > block) std::memcpy(padded, block, end - block);
+            p = padded;
+        }
+        const uint64_t escapes = escaped(match(p, '\\'));
+        quotes = match(p, '"') & ~escapes;
+        inside = prefix_xor(quotes) ^ inside_carry;
+        inside_carry = uint64_t(int64_t(inside) >> 63);
+        line_breaks = match(p, '\n') & ~escapes;
+        commas = match(p, ',') & ~escapes;
+    }
+};
+
+/* Iterates over the field separators, i.e. the commas and line breaks outside of quoted fields. */
+struct separator_iterator
+{
+    structural_indexer indexer;
+    uint64_t separators;
+
+    separator_iterator(const char *begin, const char *end)
+        : indexer(begin, end), separators(indexer.separators()) { }
+
+    /** Returns the position of the next separator, or the end of the file. */
+    const char * next() {
+        while(separators == 0) {
+            if(indexer.end - indexer.block <= std::ptrdiff_t(structural_indexer::BLOCK_SIZE)) return indexer.end;
+            indexer.advance();
+            separators = indexer.separators();
+        }
+        const char *separator = indexer.block + __builtin_ctzll(separators);
+        separators &= separators - 1;
+        return separator;
+    }
+};
+
+/** Returns true iff the 8 bytes at `p` are decimal digits. */
+bool is_eight_digits(const char *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            == 0x3333333333333333ULL);
+}
+
+/** Converts the 8 decimal digits at `p` into their value, combining pairs of digits at a time. */
+uint32_t parse_eight_digits(const char *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    v = (v & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    v = (v & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return uint32_t((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32);
+}
+
+/** Writes the field [`begin`, `end`) as the value of attribute `a` of row `i` of `range`.  Returns why the field is
+ * malformed, or `nullptr`. */
+const char * convert(const column &col, std::size_t a, const char *begin, const char *end, RowRange &range,
+                     std::size_t i)
+{
+    switch(col.kind) {
+        case column::INTEGRAL: {
+            const char *p = begin;
+            const bool negative = p < end && *p == '-';
+            if(p < end && (*p == '-' || *p == '+')) p++;
+            if(p == end) return "has an invalid integer";
+            uint64_t v = 0;
+            for(; end - p >= 8 && is_eight_digits(p); p += 8) v = v * 100000000 + parse_eight_digits(p);
+            for(; p < end; p++) {
+                if(*p < '0' || *p > '9') return "has an invalid integer";
+                v = v * 10 + (*p - '0');
+            }
+            const int64_t value = negative ? -int64_t(v) : int64_t(v);
+            switch(col.size) {
+                case 8:  range.set(a, i, int8_t(value)); break;
+                case 16: range.set(a, i, int16_t(value)); break;
+                case 32: range.set(a, i, int32_t(value)); break;
+                default: range.set(a, i, value); break;
+            }
+            break;
+        }
+
+        case column::FLOATING: {
+            //strtod needs a terminated string
+            char buffer[64];
+            const std::size_t length = std::min<std::size_t>(end - begin, sizeof(buffer) - 1);
+            std::memcpy(buffer, begin, length);
+            buffer[length] = 0;
+            char *parsed;
+            const double value = strtod(buffer, &parsed);
+            if(parsed != buffer + length) return "has an invalid floating-point number";
+            if(col.size == 32) range.set(a, i, float(value));
+            else range.set(a, i, value);
+            break;
+        }
+
+        case column::BOOLEAN: {
+            const std::size_t length = end - begin;
+            if((length == 4 && strncasecmp(begin, "true", 4) == 0) || (length == 1 && *begin == '1'))
+                range.set(a, i, true);
+            else if((length == 5 && strncasecmp(begin, "false", 5) == 0) || (length == 1 && *begin == '0'))
+                range.set(a, i, false);
+            else
+                return "has an invalid boolean";
+            break;
+        }
+
+        case column::CHARACTERS:
+            range.set(a, i, begin, end - begin, col.size);
+            break;
+    }
+    return nullptr;
+}
+
+/** Parses the record starting at `p` into row `i` of `range` and returns the beginning of the next record.  The
+ * separators of the record are taken from `separators`, the field with index `f` holds attribute `fields[f]`.
+ * Returns `nullptr` and sets `error` if the record is malformed. */
+const char * parse_record(const char *p, const char *end, separator_iterator &separators,
+                          const std::vector<column> &columns, const std::vector<std::size_t> &fields, RowRange &range,
+                          std::size_t i, std::string &unescaped, const char *&error)
+{
+    for(std::size_t f = 0; f < fields.size(); f++) {
+        const std::size_t a = fields[f];
+        const char *separator = separators.next();
+        if(f + 1 < fields.size()) {
+            if(separator == end || *separator != ',') { error = "has too few fields"; return nullptr; }
+        } else {
+            if(separator != end && *separator != '\n') { error = "has too many fields"; return nullptr; }
+        }
+
+        const char *field_begin = p, *field_end = separator;
+        if(f + 1 == fields.size() && field_end > field_begin && field_end[-1] == '\r') field_end--;
+        const bool quoted = field_begin < field_end && *field_begin == '"';
+        if(quoted) {
+            if(field_end - field_begin < 2 || field_end[-1] != '"') {
+                error = "has text after a quoted field";
+                return nullptr;
+            }
+            field_begin++;
+            field_end--;
+        }
+        //escape sequences are rare, only fields that contain one are copied
+        if(std::memchr(field_begin, '\\', field_end - field_begin) ||
+           (quoted && std::memchr(field_begin, '"', field_end - field_begin))) {
+            unescape(field_begin, field_end, unescaped);
+            field_begin = unescaped.data();
+            field_end = field_begin + unescaped.size();
+        }
+
+        const bool is_null = !quoted && field_begin == field_end;
+        range.set_null(a, i, is_null);
+        if(!is_null && (error = convert(columns[a], a, field_begin, field_end, range, i))) return nullptr;
+        p = separator == end ? end : separator + 1;
+    }
+    return p;
+}
+
+}
+
+CSVLoader::CSVLoader(m::Diagnostic &diag, const char *filename, bool has_header, unsigned num_threads)
+    : filename(filename), opened(false), data(nullptr), size(0), records_begin(nullptr), records_end(nullptr),
+      header_end(nullptr)
+{
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0) {
+        diag.e(m::Position(filename)) << "cannot open file\n";
+        if(fd >= 0) close(fd);
+        return;
+    }
+    size = st.st_size;
+    if(size > 0) {
+        void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED) {
+            diag.e(m::Position(filename)) << "cannot map file\n";
+            close(fd);
+            size = 0;
+            return;
+        }
+        data = static_cast<const char*>(p);
+        madvise(p, size, MADV_SEQUENTIAL);
+    }
+    close(fd); //the mapping stays valid
+    opened = true;
+
+    //skip the header
+    records_begin = data;
+    if(has_header && size > 0) {
+        header_end = find_line_break(data, data + size, false);
+        records_begin = header_end < data + size ? header_end + 1 : header_end;
+    }
+    //blank lines at the end of the file hold no record
+    records_end = data + size;
+    while(records_end > records_begin && (records_end[-1] == '\n' || records_end[-1] == '\r')) records_end--;
+
+    if(num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    split(num_threads);
+}
+
+CSVLoader::~CSVLoader()
+{
+    if(data != nullptr) munmap(const_cast<char*>(data), size);
+}
+
+void CSVLoader::split(unsigned num_threads)
+{
+    const char *end = records_end;
+    const std::size_t bytes = end - records_begin;
+    if(bytes == 0) return;
+
+    //cut the file into chunks of equal size, a record belongs to the chunk it starts in
+    const std::size_t num_chunks = std::max<std::size_t>(1, std::min<std::size_t>(num_threads, bytes / MIN_CHUNK_SIZE));
+    chunks.resize(num_chunks);
+    for(std::size_t j = 0; j < num_chunks; j++) {
+        //a record starts after every line break, so a line break right before a chunk starts a record in the chunk
+        const char *raw_begin = records_begin + bytes * j / num_chunks;
+        chunks[j].begin = j == 0 ? raw_begin : raw_begin - 1;
+        chunks[j].end = records_begin + bytes * (j + 1) / num_chunks;
+        //an escaped character is skipped together with the escape character in the chunk before
+        if(j != 0) {
+            std::size_t num_escapes = 0;
+            for(const char *p = chunks[j].begin; p > records_begin && p[-1] == '\\'; p--) num_escapes++;
+            if(num_escapes % 2) chunks[j].begin++;
+        }
+    }
+
+    //count the quotes and the line breaks in every chunk, for either state at the beginning of the chunk
+    struct counts { std::size_t quotes, breaks_outside, breaks_inside; };
+    std::vector<counts> c(num_chunks);
+    std::vector<std::thread> threads;
+    for(std::size_t j = 0; j < num_chunks; j++) {
+        threads.emplace_back([&, j]() {
+            //a line break belongs to the chunk of the record it starts, one at the last byte does not start a record
+            const char *stop = chunks[j].end - 1;
+            counts n{ 0, 0, 0 };
+            for(structural_indexer indexer(chunks[j].begin, end); indexer.block < stop; indexer.advance()) {
+                //ignore the bytes of the block after `stop`
+                const std::size_t valid = stop - indexer.block;
+                const uint64_t mask = valid >= structural_indexer::BLOCK_SIZE ? ~uint64_t(0) : (uint64_t(1) << valid) - 1;
+                const uint64_t breaks = indexer.line_breaks & mask;
+                n.quotes += __builtin_popcountll(indexer.quotes & mask);
+                n.breaks_outside += __builtin_popcountll(breaks & ~indexer.inside);
+                n.breaks_inside += __builtin_popcountll(breaks & indexer.inside);
+            }
+            c[j] = n;
+        });
+    }
+    for(auto &t : threads) t.join();
+
+    //the quote state at the beginning of a chunk depends on all chunks before
+    bool inside = false;
+    std::size_t row = 0;
+    for(std::size_t j = 0; j < num_chunks; j++) {
+        chunks[j].starts_quoted = inside;
+        chunks[j].first_row = row;
+        chunks[j].num_records = (j == 0) + (inside ? c[j].breaks_inside : c[j].breaks_outside);
+        row += chunks[j].num_records;
+        inside ^= c[j].quotes & 1;
+    }
+}
+
+std::size_t CSVLoader::num_records() const
+{
+    return chunks.empty() ? 0 : chunks.back().first_row + chunks.back().num_records;
+}
+
+bool CSVLoader::bind(m::Diagnostic &diag, const m::Table &table)
+{
+    std::vector<column> columns;
+    if(not describe(diag, filename.c_str(), table, columns)) return false;
+
+    //without a header, the fields are the attributes in table order
+    fields.clear();
+    if(header_end == nullptr || header_end == data) {
+        for(std::size_t a = 0; a < table.size(); a++) fields.push_back(a);
+        return true;
+    }
+
+    //split the header into the names of the fields
+    std::vector<std::string> names(1);
+    bool quoted = false;
+    for(const char *c = data; c < header_end; c++) {
+        if(*c == '"') quoted = !quoted;
+        else if(*c == ',' && !quoted) names.emplace_back();
+        else if(*c != '\r') names.back().push_back(*c);
+    }
+
+    std::vector<bool> bound(table.size(), false);
+    for(auto &name : names) {
+        std::size_t a = 0;
+        while(a < table.size() && name != table[a].name) a++;
+        if(a == table.size()) {
+            diag.e(m::Position(filename.c_str())) << "field " << name << " of the header names no attribute\n";
+            return false;
+        }
+        if(bound[a]) {
+            diag.e(m::Position(filename.c_str())) << "field " << name << " appears twice in the header\n";
+            return false;
+        }
+        bound[a] = true;
+        fields.push_back(a);
+    }
+    return true;
+}
+
+bool CSVLoader::parse(m::Diagnostic &diag, const m::Table &table, RowRange &range) const
+{
+    if(range.num_rows != num_records()) {
+        std::cout << "Error in loading CSV: " << num_records() << " records do not fit into " << range.num_rows
+                  << " rows" << "\n";
+        exit(1);
+    }
+    std::vector<column> columns;
+    if(not describe(diag, filename.c_str(), table, columns)) return false;
+    //attributes without a field are NULL
+    std::vector<std::size_t> missing;
+    for(std::size_t a = 0; a < table.size(); a++) {
+        if(std::find(fields.begin(), fields.end(), a) == fields.end()) missing.push_back(a);
+    }
+    const char *end = records_end;
+
+    //every chunk stops at its first malformed record, the first one in the file is reported
+    struct failure { std::size_t record; const char *reason; };
+    std::vector<failure> failures(chunks.size(), failure{ SIZE_MAX, nullptr });
+    std::vector<std::thread> threads;
+    for(std::size_t j = 0; j < chunks.size(); j++) {
+        threads.emplace_back([&, j]() {
+            const chunk &ch = chunks[j];
+            //find the first record of the chunk
+            const char *p = ch.begin;
+            if(p != records_begin) p = find_line_break(p, end, ch.starts_quoted) + 1;
+
+            //records start outside of quoted fields, so the separators can be indexed from here on
+            separator_iterator separators(p, end);
+            std::string unescaped;
+            for(std::size_t i = ch.first_row; i < ch.first_row + ch.num_records; i++) {
+                for(std::size_t a : missing) range.set_null(a, i, true);
+                p = parse_record(p, end, separators, columns, fields, range, i, unescaped, failures[j].reason);
+                if(p == nullptr) {
+                    failures[j].record = i;
+                    return;
+                }
+            }
+        });
+    }
+    for(auto &t : threads) t.join();
+
+    for(auto &f : failures) {
+        if(f.reason != nullptr) {
+            diag.e(m::Position(filename.c_str())) << "record " << f.record << " " << f.reason << "\n";
+            return false;
+        }
+    }
+    return true;
+}
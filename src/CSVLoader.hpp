@@ -0,0 +1,85 @@
+#pragma once
+
+#include "RowRange.hpp"
+#include <mutable/mutable.hpp>
+#include <string>
+#include <vector>
+
+
+/*
+ * Loads a CSV file into a store that supports appending rows in bulk.
+ * The file is memory-mapped and split into chunks at record boundaries, respecting quoted fields that contain
+ * delimiters or line breaks.  Records are counted first, so that all rows are appended to the store at once, then every
+ * chunk is parsed by its own thread straight into the rows of the store.  Both passes find quotes, commas, and line
+ * breaks 64 bytes at a time with SIMD comparisons and bitmask arithmetic instead of inspecting every byte.
+ * Fields are separated by ',' and may be quoted with '"'.  A backslash escapes the next character, and "" inside a
+ * quoted field escapes a quote.  An empty unquoted field is NULL.
+ * The fields of the header name the attributes they are loaded into, in any order; attributes without a field are
+ * NULL.  Without a header, the fields are the attributes in table order.  Blank lines at the end of the file are
+ * ignored.  Errors are reported to a `m::Diagnostic`.
+ */
+struct CSVLoader
+{
+    /** Chunks are not made smaller than this many bytes. */
+    static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    private:
+    struct chunk
+    {
+        const char *begin; //first byte to scan, a record starts after the first line break from here on
+        const char *end; //records starting before this byte belong to the chunk
+        bool starts_quoted; //whether `begin` lies inside a quoted field
+        std::size_t first_row; //index of the first record of the chunk in the file
+        std::size_t num_records;
+    };
+
+    std::string filename;
+    bool opened; //whether the file could be mapped
+    const char *data; //the mapped file
+    std::size_t size;
+    const char *records_begin; //first byte after the header
+    const char *records_end; //first byte of the line breaks at the end of the file
+    const char *header_end; //line break after the header, `nullptr` without a header
+    std::vector<chunk> chunks;
+    std::vector<std::size_t> fields; //the attribute of every field of a record
+
+    void split(unsigned num_threads);
+
+    public:
+    /** Maps the file `filename` and splits it into at most `num_threads` chunks.  `num_threads == 0` uses one thread
+     * per hardware thread.  A file that cannot be mapped is reported to `diag` and has no records. */
+    CSVLoader(m::Diagnostic &diag, const char *filename, bool has_header = true, unsigned num_threads = 0);
+    ~CSVLoader();
+
+    CSVLoader(const CSVLoader&) = delete;
+
+    /** Returns true iff the file was mapped. */
+    bool is_open() const { return opened; }
+    /** Returns the number of records in the file, not counting the header. */
+    std::size_t num_records() const;
+    /** Returns the number of chunks parsed in parallel. */
+    std::size_t num_chunks() const { return chunks.size(); }
+
+    /** Maps the fields of the header to the attributes of `table` by name.  Returns false and reports to `diag` if a
+     * field names no attribute or an attribute has a type that cannot be loaded. */
+    bool bind(m::Diagnostic &diag, const m::Table &table);
+    /** Parses all records into `range`, which must hold `num_records()` rows of a store backing `table`.  Returns
+     * false and reports the first malformed record to `diag`; the rows of the range are then partially written. */
+    bool parse(m::Diagnostic &diag, const m::Table &table, RowRange &range) const;
+
+    /** Loads the file `filename` into `store`, which must offer `append(n)` and `drop()`.  Returns the number of
+     * loaded rows.  On errors, which are reported to `diag`, no row is loaded. */
+    template<typename Store>
+    static std::size_t Load(m::Diagnostic &diag, Store &store, const char *filename, bool has_header = true,
+                            unsigned num_threads = 0) {
+        CSVLoader loader(diag, filename, has_header, num_threads);
+        if(not loader.is_open() || not loader.bind(diag, store.table())) return 0;
+        const std::size_t num_rows = store.num_rows();
+        RowRange range = store.append(loader.num_records());
+        if(not loader.parse(diag, store.table(), range)) {
+            while(store.num_rows() > num_rows) store.drop();
+            return 0;
+        }
+        return loader.num_records();
+    }
+};
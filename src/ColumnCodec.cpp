@@ -0,0 +1,178 @@
+/*
+Implementation of the lightweight compression schemes for column chunks
+*/
+
+#include "ColumnCodec.hpp"
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+
+namespace {
+
+/** Returns the number of bits needed to represent `v`. */
+unsigned bits_needed(uint64_t v) { return v == 0 ? 0 : 64 - __builtin_clzll(v); }
+
+std::size_t packed_words(std::size_t n, unsigned width) { return (n * width + 63) / 64; }
+
+/** Packs the low `width` bits of every value in `in` densely into 64 bit words. */
+std::vector<uint64_t> pack(const std::vector<uint64_t> &in, unsigned width)
+{
+    std::vector<uint64_t> out(packed_words(in.size(), width), 0);
+    for(std::size_t i = 0; i < in.size() && width; i++) {
+        const std::size_t bit = i * width;
+        const std::size_t word = bit / 64, offset = bit % 64;
+        out[word] |= in[i] << offset;
+        //values may straddle two words
+        if(offset + width > 64) out[word + 1] |= in[i] >> (64 - offset);
+    }
+    return out;
+}
+
+/** Returns the `i`-th value of `width` bits packed by `pack()`. */
+uint64_t unpack(const std::vector<uint64_t> &in, unsigned width, std::size_t i)
+{
+    if(width == 0) return 0;
+    const std::size_t bit = i * width;
+    const std::size_t word = bit / 64, offset = bit % 64;
+    uint64_t v = in[word] >> offset;
+    if(offset + width > 64) v |= in[word + 1] << (64 - offset);
+    return width == 64 ? v : v & ((uint64_t(1) << width) - 1);
+}
+
+/** Reads a little endian signed integer of `stride` bytes. */
+int64_t load_integer(const char *p, std::size_t stride)
+{
+    switch(stride) {
+        case 1: { int8_t v; std::memcpy(&v, p, 1); return v; }
+        case 2: { int16_t v; std::memcpy(&v, p, 2); return v; }
+        case 4: { int32_t v; std::memcpy(&v, p, 4); return v; }
+        default: { int64_t v; std::memcpy(&v, p, 8); return v; }
+    }
+}
+
+}
+
+CompressedChunk CompressedChunk::Compress(const char *data, std::size_t num_rows, std::size_t stride, bool is_integral)
+{
+    CompressedChunk chunk;
+    chunk.num_rows_ = num_rows;
+    chunk.stride_ = stride;
+    if(num_rows == 0 || stride == 0) return chunk;
+
+    const std::size_t plain_size = num_rows * stride;
+
+    //RLE: count the runs of equal values
+    std::size_t num_runs = 1;
+    for(std::size_t i = 1; i < num_rows; i++)
+        num_runs += std::memcmp(data + (i - 1) * stride, data + i * stride, stride) != 0;
+    const std::size_t rle_size = num_runs * (stride + sizeof(uint32_t));
+
+    //DICTIONARY: assign codes in order of first occurrence, give up once the dictionary grows too large
+    std::unordered_map<std::string_view, uint64_t> dictionary;
+    std::vector<uint64_t> codes;
+    std::size_t dictionary_size = SIZE_MAX;
+    codes.reserve(num_rows);
+    for(std::size_t i = 0; i < num_rows; i++) {
+        auto it = dictionary.emplace(std::string_view(data + i * stride, stride), dictionary.size()).first;
+        if(dictionary.size() > MAX_DICTIONARY_SIZE) break;
+        codes.push_back(it->second);
+    }
+    const unsigned code_width = bits_needed(dictionary.size() - 1);
+    if(codes.size() == num_rows)
+        dictionary_size = dictionary.size() * stride + packed_words(num_rows, code_width) * sizeof(uint64_t);
+
+    //BITPACK: frame of reference over the minimum of the chunk
+    std::size_t bitpack_size = SIZE_MAX;
+    int64_t min = 0, max = 0;
+    if(is_integral && (stride == 1 || stride == 2 || stride == 4 || stride == 8)) {
+        min = max = load_integer(data, stride);
+        for(std::size_t i = 1; i < num_rows; i++) {
+            const int64_t v = load_integer(data + i * stride, stride);
+            if(v < min) min = v;
+            if(v > max) max = v;
+        }
+        bitpack_size = packed_words(num_rows, bits_needed(uint64_t(max) - uint64_t(min))) * sizeof(uint64_t)
+                       + sizeof(uint64_t);
+    }
+
+    //keep the smallest encoding
+    std::size_t best = plain_size;
+    chunk.scheme_ = PLAIN;
+    if(rle_size < best) { best = rle_size; chunk.scheme_ = RLE; }
+    if(dictionary_size < best) { best = dictionary_size; chunk.scheme_ = DICTIONARY; }
+    if(bitpack_size < best) { best = bitpack_size; chunk.scheme_ = BITPACK; }
+
+    switch(chunk.scheme_) {
+        case PLAIN:
+            chunk.values.assign(data, data + plain_size);
+            break;
+
+        case RLE:
+            chunk.values.reserve(num_runs * stride);
+            chunk.run_lengths.reserve(num_runs);
+            for(std::size_t i = 0; i < num_rows; i++) {
+                const char *v = data + i * stride;
+                if(i == 0 || std::memcmp(v - stride, v, stride) != 0) {
+                    chunk.values.insert(chunk.values.end(), v, v + stride);
+                    chunk.run_lengths.push_back(0);
+                }
+                chunk.run_lengths.back()++;
+            }
+            break;
+
+        case DICTIONARY:
+            chunk.values.resize(dictionary.size() * stride);
+            for(auto &entry : dictionary)
+                std::memcpy(chunk.values.data() + entry.second * stride, entry.first.data(), stride);
+            chunk.bit_width = code_width;
+            chunk.packed = pack(codes, code_width);
+            break;
+
+        case BITPACK: {
+            std::vector<uint64_t> deltas(num_rows);
+            for(std::size_t i = 0; i < num_rows; i++)
+                deltas[i] = uint64_t(load_integer(data + i * stride, stride)) - uint64_t(min);
+            chunk.reference = uint64_t(min);
+            chunk.bit_width = bits_needed(uint64_t(max) - uint64_t(min));
+            chunk.packed = pack(deltas, chunk.bit_width);
+            break;
+        }
+    }
+    return chunk;
+}
+
+void CompressedChunk::decompress(char *out) const
+{
+    switch(scheme_) {
+        case PLAIN:
+            std::memcpy(out, values.data(), values.size());
+            break;
+
+        case RLE:
+            for(std::size_t r = 0; r < run_lengths.size(); r++) {
+                for(uint32_t i = 0; i < run_lengths[r]; i++, out += stride_)
+                    std::memcpy(out, values.data() + r * stride_, stride_);
+            }
+            break;
+
+        case DICTIONARY:
+            for(std::size_t i = 0; i < num_rows_; i++)
+                std::memcpy(out + i * stride_, values.data() + unpack(packed, bit_width, i) * stride_, stride_);
+            break;
+
+        case BITPACK:
+            //the low bytes of the little endian sum are the value truncated to `stride_` bytes
+            for(std::size_t i = 0; i < num_rows_; i++) {
+                const uint64_t v = reference + unpack(packed, bit_width, i);
+                std::memcpy(out + i * stride_, &v, stride_);
+            }
+            break;
+    }
+}
+
+std::size_t CompressedChunk::size_in_bytes() const
+{
+    return values.size() + run_lengths.size() * sizeof(uint32_t) + packed.size() * sizeof(uint64_t)
+           + (scheme_ == BITPACK ? sizeof(reference) : 0);
+}
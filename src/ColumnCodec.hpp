@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/*
+ * A compressed chunk of a column.
+ * Values are fixed-size byte strings of `stride` bytes, which covers every attribute type of the column store.
+ * A chunk is an encoded copy of the values, the column it was compressed from keeps its memory.
+ * `Compress` encodes a chunk with every applicable scheme and keeps the smallest encoding:
+ *  - PLAIN: the values as they are.
+ *  - DICTIONARY: the distinct values once, and per row the bit-packed position of its value in the dictionary.
+ *  - RLE: one value and one run length per run of equal values.
+ *  - BITPACK: integers only, the minimum of the chunk and per row the bit-packed difference to it.
+ */
+struct CompressedChunk
+{
+    enum scheme_t { PLAIN, DICTIONARY, RLE, BITPACK };
+
+    /** Dictionaries with more entries than this are not built. */
+    static constexpr std::size_t MAX_DICTIONARY_SIZE = 1 << 12;
+
+    private:
+    scheme_t scheme_;
+    std::size_t num_rows_;
+    std::size_t stride_; //bytes per value
+    unsigned bit_width; //bits per row of DICTIONARY and BITPACK
+    uint64_t reference; //minimum of a BITPACK chunk
+    std::vector<char> values; //raw values of PLAIN, dictionary of DICTIONARY, run values of RLE
+    std::vector<uint32_t> run_lengths; //RLE only
+    std::vector<uint64_t> packed; //bit-packed codes of DICTIONARY and BITPACK
+
+    public:
+    CompressedChunk() : scheme_(PLAIN), num_rows_(0), stride_(0), bit_width(0), reference(0) { }
+
+    /** Compresses `num_rows` values of `stride` bytes at `data`.  `is_integral` enables BITPACK for strides of 1, 2,
+     * 4, and 8 bytes; the values are then read as little endian signed integers. */
+    static CompressedChunk Compress(const char *data, std::size_t num_rows, std::size_t stride, bool is_integral);
+
+    /** Writes the `num_rows()` values of the chunk to `out`, which must hold `num_rows() * stride()` bytes. */
+    void decompress(char *out) const;
+
+    scheme_t scheme() const { return scheme_; }
+    std::size_t num_rows() const { return num_rows_; }
+    std::size_t stride() const { return stride_; }
+
+    /** Returns the number of bytes occupied by the encoded chunk. */
+    std::size_t size_in_bytes() const;
+};
@@ -0,0 +1,333 @@
+/*
+Implementation of the column-group store
+*/
+
+#include "ColumnGroupStore.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <string>
+
+
+namespace {
+
+//alignment of an attribute in bits; booleans are packed bitwise, character sequences are aligned to bytes
+uint64_t alignment_of(const m::Attribute &attr)
+{
+    uint64_t size = attr.type->size();
+    if(size <= 1) return 1;
+    if(attr.type->is_character_sequence()) return 8;
+    return size;
+}
+
+}
+
+ColumnGroupStore::ColumnGroupStore(const m::Table &table, std::vector<group_t> column_groups, AllocationPolicy policy)
+    : Store(table)
+    , num_rows_(0)
+    , locations(table.size())
+{
+    if(column_groups.empty()) {
+        column_groups.emplace_back();
+        for(std::size_t i = 0; i != table.size(); ++i) column_groups.back().push_back(i);
+    }
+
+    /*Check that every attribute belongs to exactly one group. */
+    std::vector<bool> covered(table.size());
+    for(auto &attributes : column_groups) {
+        for(auto i : attributes) {
+            if(i >= table.size() || covered[i]) {
+                std::cout << "Error in column groups: attribute " << i << " is out of range or in several groups"
+                          << "\n";
+                exit(1);
+            }
+            covered[i] = true;
+        }
+    }
+    if(std::find(covered.begin(), covered.end(), false) != covered.end()) {
+        std::cout << "Error in column groups: not every attribute belongs to a group" << "\n";
+        exit(1);
+    }
+
+    /*Lay out every group like a row, placing attributes by decreasing alignment so that they need no padding. */
+    for(auto &attributes : column_groups) {
+        if(attributes.empty()) continue;
+        group_t order = attributes;
+        std::stable_sort(order.begin(), order.end(), [&table](std::size_t left, std::size_t right) {
+            return alignment_of(table[left]) > alignment_of(table[right]);
+        });
+        uint64_t offset = 0, max_align = 8;
+        for(auto i : order) {
+            uint64_t align = alignment_of(table[i]);
+            offset = (offset + align - 1) / align * align;
+            max_align = std::max(max_align, align);
+            locations[i] = { groups.size(), offset };
+            offset += table[i].type->size();
+        }
+        std::size_t stride = (offset + max_align - 1) / max_align * max_align / 8;
+        groups.push_back(group{ attributes, stride, BlockArena(BlockArena::DEFAULT_BLOCK_SIZE, MAX_ROWS * stride,
+                                                               policy) });
+    }
+    /*Add a column for the null bitmaps. */
+    std::size_t bitmap_stride = std::max<std::size_t>((table.size() + 7) / 8, 1);
+    groups.push_back(group{ {}, bitmap_stride, BlockArena(BlockArena::DEFAULT_BLOCK_SIZE, MAX_ROWS * bitmap_stride,
+                                                          policy) });
+
+    /*Commit the first block of every group. */
+    reserve(1);
+
+    /*Create linearization. */
+    createLinearization();
+}
+
+ColumnGroupStore::~ColumnGroupStore()
+{
+    /*Allocated blocks are freed by the arenas. */
+    num_rows_ = 0;
+    capacity = 0;
+}
+
+void ColumnGroupStore::createLinearization()
+{
+    //every group is an infinite sequence of rows, each row holding the attributes of the group
+    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(groups.size()));
+    for(std::size_t g = 0; g != groups.size() - 1; ++g) {
+        auto row = std::make_unique<m::Linearization>(
+            m::Linearization::CreateFinite(groups[g].attributes.size(), 1));
+        for(auto i : groups[g].attributes) {
+            row->add_sequence(locations[i].second, 0, table()[i]);
+        }
+        lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(groups[g].rows.data())), groups[g].stride,
+                          std::move(row));
+    }
+    //null bitmap
+    auto null_bm = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
+    null_bm->add_null_bitmap(0, 0);
+    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(groups.back().rows.data())), groups.back().stride,
+                      std::move(null_bm));
+    linearization(std::move(lin));
+}
+
+std::vector<ColumnGroupStore::group_t> ColumnGroupStore::Propose(const m::Table &table,
+                                                                 const std::vector<group_t> &queries)
+{
+    //the access signature of an attribute is the set of queries that access it
+    std::vector<std::vector<bool>> signatures(table.size(), std::vector<bool>(queries.size()));
+    for(std::size_t q = 0; q != queries.size(); ++q) {
+        for(auto i : queries[q]) {
+            if(i < table.size()) signatures[i][q] = true;
+        }
+    }
+
+    //group attributes with equal signatures, in the order of their first attribute
+    std::vector<group_t> result;
+    std::map<std::vector<bool>, std::size_t> group_of;
+    for(std::size_t i = 0; i != table.size(); ++i) {
+        auto it = group_of.emplace(signatures[i], result.size()).first;
+        if(it->second == result.size()) result.emplace_back();
+        result[it->second].push_back(i);
+    }
+    return result;
+}
+
+std::vector<ColumnGroupStore::group_t> ColumnGroupStore::ReadQueryLog(const m::Table &table, std::istream &in)
+{
+    std::string log(std::istreambuf_iterator<char>(in), {});
+    std::vector<group_t> queries;
+
+    //split the log into statements of tokens: identifiers, and single characters otherwise; literals become a quote
+    std::vector<std::vector<std::string>> statements(1);
+    for(std::size_t pos = 0; pos < log.size(); ) {
+        char c = log[pos];
+        if(std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            std::size_t end = pos;
+            while(end < log.size() && (std::isalnum(static_cast<unsigned char>(log[end])) || log[end] == '_')) end++;
+            statements.back().push_back(log.substr(pos, end - pos));
+            pos = end;
+        } else if(std::isdigit(static_cast<unsigned char>(c))) {
+            while(pos < log.size() && (std::isalnum(static_cast<unsigned char>(log[pos])) || log[pos] == '.')) pos++;
+            statements.back().push_back("0");
+        } else if(c == '"' || c == '\'') {
+            pos = log.find(c, pos + 1);
+            pos = pos == std::string::npos ? log.size() : pos + 1;
+            statements.back().push_back("\"");
+        } else if(c == ';') {
+            statements.emplace_back();
+            pos++;
+        } else {
+            if(not std::isspace(static_cast<unsigned char>(c))) statements.back().push_back(std::string(1, c));
+            pos++;
+        }
+    }
+
+    auto is_keyword = [](const std::string &token, const char *keyword) {
+        return token.size() == std::strlen(keyword) &&
+               std::equal(token.begin(), token.end(), keyword, [](char t, char k) { return std::toupper(t) == k; });
+    };
+    auto ends_from = [&](const std::string &token) {
+        for(const char *keyword : { "WHERE", "GROUP", "ORDER", "HAVING", "LIMIT", "UNION" }) {
+            if(is_keyword(token, keyword)) return true;
+        }
+        return token == ")";
+    };
+    auto is_identifier = [](const std::string &token) {
+        return std::isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_';
+    };
+
+    for(auto &tokens : statements) {
+        //find the FROM clause, and the names under which it refers to the table
+        std::size_t from = 0;
+        while(from < tokens.size() && not is_keyword(tokens[from], "FROM")) from++;
+        std::size_t from_end = from;
+        std::vector<std::string> names;
+        std::size_t num_tables = 0;
+        for(std::size_t t = from + 1; t < tokens.size() && not ends_from(tokens[t]); t = from_end) {
+            //an entry of the FROM clause is `table [[AS] alias]`, up to the next ','
+            for(from_end = t; from_end < tokens.size() && tokens[from_end] != "," && not ends_from(tokens[from_end]); )
+                from_end++;
+            num_tables++;
+            if(tokens[t] == table.name) {
+                names.push_back(tokens[t]);
+                const std::size_t alias = t + 1 < from_end && is_keyword(tokens[t + 1], "AS") ? t + 2 : t + 1;
+                if(alias < from_end && is_identifier(tokens[alias])) names.push_back(tokens[alias]);
+            }
+            if(from_end < tokens.size() && tokens[from_end] == ",") from_end++;
+        }
+        if(names.empty()) continue; //the statement does not read the table
+
+        std::vector<bool> mentioned(table.size());
+        bool any = false;
+        auto mention = [&](const std::string &name) {
+            for(std::size_t i = 0; i != table.size(); ++i) {
+                if(name == table[i].name) {
+                    mentioned[i] = true;
+                    any = true;
+                }
+            }
+        };
+        auto names_table = [&](const std::string &qualifier) {
+            return std::find(names.begin(), names.end(), qualifier) != names.end();
+        };
+        for(std::size_t t = 0; t < tokens.size(); t++) {
+            if(t == from) t = from_end; //the FROM clause names tables only
+            if(t >= tokens.size()) break;
+            const std::string &token = tokens[t];
+            const bool qualified = t >= 2 && tokens[t - 1] == ".";
+            if(qualified && not names_table(tokens[t - 2])) continue; //a column of another table
+            if(token == "*") {
+                //every attribute, unless it multiplies
+                if(qualified || t == 0 || is_keyword(tokens[t - 1], "SELECT") || tokens[t - 1] == ",") {
+                    mentioned.assign(table.size(), true);
+                    any = true;
+                }
+            } else if(is_identifier(token)) {
+                //qualifiers and aliases of the select list name no attribute
+                const bool qualifier = t + 1 < tokens.size() && tokens[t + 1] == ".";
+                const bool alias = t >= 1 && is_keyword(tokens[t - 1], "AS");
+                if(not qualifier && not alias && (qualified || num_tables == 1)) mention(token);
+            }
+        }
+        if(any) {
+            queries.emplace_back();
+            for(std::size_t i = 0; i != table.size(); ++i) {
+                if(mentioned[i]) queries.back().push_back(i);
+            }
+        }
+    }
+    return queries;
+}
+
+std::vector<ColumnGroupStore::group_t> ColumnGroupStore::column_groups() const
+{
+    std::vector<group_t> result;
+    for(std::size_t g = 0; g != groups.size() - 1; ++g) {
+        result.push_back(groups[g].attributes);
+    }
+    return result;
+}
+
+std::size_t ColumnGroupStore::num_rows() const
+{
+    return num_rows_;
+}
+
+void ColumnGroupStore::reserve(std::size_t num_rows)
+{
+    //commit the next blocks of every group that is too small; groups are never moved
+    std::size_t new_capacity = MAX_ROWS;
+    for(auto &g : groups) {
+        g.rows.reserve(num_rows * g.stride);
+        new_capacity = std::min(new_capacity, g.rows.size() / g.stride);
+    }
+    capacity = new_capacity;
+}
+
+void ColumnGroupStore::grow(std::size_t n)
+{
+    if(num_rows_ + n > capacity) {
+        reserve(num_rows_ + n);
+    }
+    num_rows_ += n;
+}
+
+void ColumnGroupStore::append()
+{
+    grow(1);
+}
+
+RowRange ColumnGroupStore::append(std::size_t n)
+{
+    RowRange range{ num_rows_, n, layouts() };
+    grow(n);
+    return range;
+}
+
+std::vector<AttributeLayout> ColumnGroupStore::layouts() const
+{
+    //every block is a single row of a group
+    std::vector<AttributeLayout> result;
+    for(auto &location : locations) {
+        auto &g = groups[location.first];
+        result.push_back(AttributeLayout{ g.rows.data(), 1, g.stride, location.second, 0 });
+    }
+    result.push_back(AttributeLayout{ groups.back().rows.data(), 1, groups.back().stride, 0, 0 });
+    return result;
+}
+
+void ColumnGroupStore::drop()
+{
+    if(num_rows_ > 0) num_rows_--;
+
+    //return unused blocks of every group to the OS once the table shrank enough
+    bool trimmed = false;
+    for(auto &g : groups) {
+        trimmed |= g.rows.trim(num_rows_ * g.stride);
+    }
+    if(trimmed) {
+        capacity = MAX_ROWS;
+        for(auto &g : groups) {
+            capacity = std::min(capacity, g.rows.size() / g.stride);
+        }
+    }
+}
+
+void ColumnGroupStore::dump(std::ostream &out) const
+{
+    /*Print description of this store to `out`. */
+    for(std::size_t g = 0; g != groups.size(); ++g) {
+        if(g == groups.size() - 1) {
+            out << "Null bitmaps";
+        } else {
+            out << "Group " << g << " (";
+            for(auto i : groups[g].attributes) {
+                out << (i == groups[g].attributes.front() ? "" : ", ") << table()[i].name;
+            }
+            out << ")";
+        }
+        out << ": " << groups[g].stride << " bytes per row in " << groups[g].rows.num_blocks() << " blocks" << "\n";
+    }
+    out << num_rows_ << " rows in use and " << capacity << " rows are allocated." << std::endl;
+    out.flush();
+}
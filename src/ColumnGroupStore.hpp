@@ -0,0 +1,75 @@
+#pragma once
+
+#include "BlockArena.hpp"
+#include "RowRange.hpp"
+#include <istream>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+/*
+ * Vertically partitioned layout.
+ * The attributes of a table are split into column groups.  Each group is stored row-wise in its own arena, with its
+ * attributes ordered by decreasing alignment, and the null bitmaps of all attributes are stored in a separate column.
+ * A query that reads only the attributes of one group touches only the memory of that group.
+ */
+struct ColumnGroupStore : m::Store
+{
+    using group_t = std::vector<std::size_t>; //indices of the attributes of a group
+
+    /** Rows are never moved, so a group can hold at most this many rows. */
+    static constexpr std::size_t MAX_ROWS = std::size_t(1) << 31;
+
+    private:
+    struct group
+    {
+        group_t attributes;
+        std::size_t stride; //bytes per row
+        BlockArena rows;
+    };
+
+    std::size_t num_rows_, capacity;
+    std::vector<group> groups; //the last group holds the null bitmaps
+    std::vector<std::pair<std::size_t, uint64_t>> locations; //group and bit offset in the group of every attribute
+
+    void createLinearization();
+    void grow(std::size_t n);
+
+    public:
+    /** Creates a store with the column groups `column_groups`, which must cover every attribute of `table` exactly
+     * once.  If `column_groups` is empty, all attributes form a single group. */
+    ColumnGroupStore(const m::Table &table, std::vector<group_t> column_groups = {},
+                     AllocationPolicy policy = AllocationPolicy());
+    ~ColumnGroupStore();
+
+    /** Proposes column groups for `table` from `queries`, where each query is given by the indices of the attributes
+     * it accesses.  Attributes that are accessed by exactly the same queries are grouped together, so that no query
+     * reads an attribute it does not need and no query has to combine more groups than necessary.  Attributes that
+     * are never accessed form a group of their own. */
+    static std::vector<group_t> Propose(const m::Table &table, const std::vector<group_t> &queries);
+    /** Reads a log of SQL statements separated by ';' from `in` and returns, for every statement whose FROM clause
+     * names `table`, the attributes of `table` that it mentions.  Names qualified by the table or its alias are
+     * attributes of the table, names qualified otherwise are not; unqualified names only count in statements that read
+     * a single table.  A `*` in the select list mentions every attribute, aliases and literals mention none. */
+    static std::vector<group_t> ReadQueryLog(const m::Table &table, std::istream &in);
+
+    /** Returns the column groups, without the null bitmaps. */
+    std::vector<group_t> column_groups() const;
+
+    /** Returns the location of every attribute and of the null bitmaps. */
+    std::vector<AttributeLayout> layouts() const;
+    /** Commits memory for `num_rows` rows in total, so that appending up to that many rows never grows the store. */
+    void reserve(std::size_t num_rows);
+    /** Appends `n` rows at once and returns them for writing. */
+    RowRange append(std::size_t n);
+
+    std::size_t num_rows() const override;
+    void append() override;
+    void drop() override;
+
+    void accept(m::StoreVisitor &v) override { v(*this); }
+    void accept(m::ConstStoreVisitor &v) const override { v(*this); }
+
+    void dump(std::ostream &out) const override;
+    using Store::dump;
+};
@@ -0,0 +1,286 @@
+/*
+Implementation of the read-optimized main of the column store
+*/
+
+#include "ColumnMain.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+ColumnMain::~ColumnMain()
+{
+    if(merger.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            stop_merging = true;
+        }
+        merge_wake.notify_one();
+        merger.join();
+    }
+}
+
+int64_t ColumnMain::integer_at(std::size_t attr, std::size_t row) const
+{
+    const char *p = columns.at(attr).data + row * columns.at(attr).stride;
+    auto load = [p](auto value) {
+        std::memcpy(&value, p, sizeof(value));
+        return int64_t(value);
+    };
+    switch(columns.at(attr).stride) {
+        case 1: return load(int8_t());
+        case 2: return load(int16_t());
+        case 4: return load(int32_t());
+        default: return load(int64_t());
+    }
+}
+
+bool ColumnMain::is_null(std::size_t attr, std::size_t row) const
+{
+    const char *bitmap = columns.back().data + row * columns.back().stride;
+    return not ((bitmap[attr / 8] >> (attr % 8)) & 1); // a set bit marks a present value
+}
+
+void ColumnMain::sort(std::size_t chunk)
+{
+    const std::size_t first = chunk * chunk_rows_;
+    std::vector<std::pair<bool, int64_t>> keys(chunk_rows_);
+    std::vector<uint32_t> order(chunk_rows_);
+    for(std::size_t i = 0; i != chunk_rows_; ++i) {
+        const bool null = is_null(sort_key, first + i);
+        keys[i] = { null, null ? 0 : integer_at(sort_key, first + i) };
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t left, uint32_t right) {
+        return keys[left] < keys[right];
+    });
+
+    // move the values of every column to the sorted positions of their rows
+    std::vector<char> buffer;
+    for(uint32_t x = 0; x < columns.size(); x++) {
+        char *data = columns.at(x).data + bytes_of(x, first);
+        buffer.assign(data, data + bytes_of(x, chunk_rows_));
+        const std::size_t stride = columns.at(x).stride;
+        if(columns.at(x).packed_rows > 1) {
+            for(std::size_t i = 0; i != chunk_rows_; ++i) {
+                const bool bit = (buffer[order[i] / 8] >> (order[i] % 8)) & 1;
+                data[i / 8] = (data[i / 8] & ~(1 << (i % 8))) | (bit << (i % 8));
+            }
+        } else {
+            for(std::size_t i = 0; i != chunk_rows_; ++i) {
+                std::memcpy(data + i * stride, buffer.data() + order[i] * stride, stride);
+            }
+        }
+    }
+}
+
+void ColumnMain::build(secondary_index &index, std::size_t chunk)
+{
+    // bulkload the (value, row id) pairs of the rows of the chunk, sorted by value
+    std::vector<std::pair<int64_t, uint32_t>> entries;
+    entries.reserve(chunk_rows_);
+    for(std::size_t row = chunk * chunk_rows_; row != (chunk + 1) * chunk_rows_; ++row) {
+        if(not is_null(index.attr, row)) entries.emplace_back(integer_at(index.attr, row), uint32_t(row));
+    }
+    std::sort(entries.begin(), entries.end());
+    // the tree is constructed in place, it must not be moved
+    index.trees.emplace_back(new index_type(index_type::Bulkload(entries)));
+}
+
+void ColumnMain::seal(std::size_t chunk)
+{
+    for(uint32_t x = 0; x < columns.size(); x++) {
+        // the bytes of a bit-packed chunk are compressed as values of their own
+        const column &c = columns.at(x);
+        compressed.at(x).push_back(CompressedChunk::Compress(c.data + bytes_of(x, chunk * chunk_rows_),
+                                                             chunk_rows_ / c.packed_rows, c.stride, c.integral));
+    }
+}
+
+void ColumnMain::merge_chunk(std::size_t chunk)
+{
+    std::unique_lock<std::shared_mutex> lock(main_mutex);
+    if(sort_key != NO_SORT_KEY) sort(chunk);
+    for(auto &index : indexes) build(index, chunk);
+    if(compression) seal(chunk);
+    merged_chunks.store(chunk + 1);
+}
+
+void ColumnMain::enable_compression()
+{
+    if(requested_chunks != 0) {
+        std::cout << "Error in ColumnMain::enable_compression: chunks were handed to merging" << "\n";
+        exit(1);
+    }
+    compression = true;
+}
+
+void ColumnMain::sort_by(std::size_t attr)
+{
+    if(attr + 1 >= columns.size() || not columns.at(attr).integral) {
+        std::cout << "Error in ColumnMain::sort_by: column " << attr << " is not an integral column" << "\n";
+        exit(1);
+    }
+    if(requested_chunks != 0) {
+        std::cout << "Error in ColumnMain::sort_by: chunks were handed to merging" << "\n";
+        exit(1);
+    }
+    sort_key = attr;
+}
+
+void ColumnMain::add_index(std::size_t attr)
+{
+    if(attr + 1 >= columns.size() || not columns.at(attr).integral) {
+        std::cout << "Error in ColumnMain::add_index: column " << attr << " is not an integral column" << "\n";
+        exit(1);
+    }
+    std::unique_lock<std::shared_mutex> lock(main_mutex);
+    for(auto &index : indexes) {
+        if(index.attr == attr) return;
+    }
+    // chunks merged before are indexed right away
+    indexes.push_back({ attr, {} });
+    for(std::size_t chunk = 0; chunk != merged_chunks.load(); ++chunk) build(indexes.back(), chunk);
+}
+
+const ColumnMain::index_type & ColumnMain::index(std::size_t attr, std::size_t chunk) const
+{
+    std::shared_lock<std::shared_mutex> lock(main_mutex);
+    auto it = std::find_if(indexes.begin(), indexes.end(), [attr](auto &index) { return index.attr == attr; });
+    if(it == indexes.end() || chunk >= it->trees.size()) {
+        std::cout << "Error in ColumnMain::index: column " << attr << " has no index of chunk " << chunk << "\n";
+        exit(1);
+    }
+    return *it->trees[chunk];
+}
+
+void ColumnMain::in_range(std::size_t attr, int64_t lower, int64_t upper, std::size_t num_rows,
+                          const std::function<void(std::size_t)> &callback) const
+{
+    std::shared_lock<std::shared_mutex> lock(main_mutex);
+    auto it = std::find_if(indexes.begin(), indexes.end(), [attr](auto &index) { return index.attr == attr; });
+    std::size_t filtered = 0; // the first row that is filtered one by one
+    if(it != indexes.end()) {
+        // the trees are only replaced while `main_mutex` is held exclusively
+        for(auto &tree : it->trees) {
+            for(auto &entry : static_cast<const index_type&>(*tree).in_range(lower, upper)) {
+                callback(entry.second);
+            }
+        }
+        filtered = sealed_rows();
+    } else if(attr == sort_key) {
+        // binary search the first row of the range in every chunk of the main, NULLs come last
+        for(std::size_t begin = 0; begin != sealed_rows(); begin += chunk_rows_) {
+            const std::size_t end = begin + chunk_rows_;
+            std::size_t lo = begin, hi = end;
+            while(lo < hi) {
+                const std::size_t mid = lo + (hi - lo) / 2;
+                if(not is_null(attr, mid) && integer_at(attr, mid) < lower) lo = mid + 1;
+                else hi = mid;
+            }
+            for(std::size_t row = lo; row != end && not is_null(attr, row) && integer_at(attr, row) < upper; ++row) {
+                callback(row);
+            }
+        }
+        filtered = sealed_rows();
+    }
+
+    for(std::size_t row = filtered; row < num_rows; ++row) {
+        if(is_null(attr, row)) continue;
+        const int64_t value = integer_at(attr, row);
+        if(value >= lower && value < upper) callback(row);
+    }
+}
+
+void ColumnMain::scan(std::size_t attr, std::size_t num_rows,
+                      const std::function<void(const char*, std::size_t)> &callback) const
+{
+    std::shared_lock<std::shared_mutex> lock(main_mutex);
+    std::vector<char> buffer(bytes_of(attr, chunk_rows_));
+
+    // compressed chunks are decompressed one at a time
+    for(auto &chunk : compressed.at(attr)) {
+        chunk.decompress(buffer.data());
+        callback(buffer.data(), chunk.num_rows() * columns.at(attr).packed_rows);
+    }
+
+    // the rows after the last compressed chunk are read in place
+    const std::size_t sealed_rows = compressed.at(attr).size() * chunk_rows_;
+    if(num_rows > sealed_rows) {
+        callback(columns.at(attr).data + bytes_of(attr, sealed_rows), num_rows - sealed_rows);
+    }
+}
+
+void ColumnMain::merge_in_background()
+{
+    if(merger.joinable()) return;
+    merge_target = requested_chunks;
+    merger = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(merge_mutex);
+        for(;;) {
+            merge_wake.wait(lock, [this]() { return stop_merging || merged_chunks.load() < merge_target; });
+            if(stop_merging) return;
+            lock.unlock();
+            merge_chunk(merged_chunks.load());
+            lock.lock();
+            merge_done.notify_all();
+        }
+    });
+}
+
+void ColumnMain::merge(std::size_t num_chunks)
+{
+    if(requested_chunks >= num_chunks) return;
+    requested_chunks = num_chunks;
+    if(merger.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            merge_target = num_chunks;
+        }
+        merge_wake.notify_one();
+    } else {
+        while(merged_chunks.load() < num_chunks) merge_chunk(merged_chunks.load());
+    }
+}
+
+void ColumnMain::wait()
+{
+    if(not merger.joinable()) return;
+    std::unique_lock<std::mutex> lock(merge_mutex);
+    merge_done.wait(lock, [this]() { return merged_chunks.load() == merge_target; });
+}
+
+void ColumnMain::truncate(std::size_t num_rows)
+{
+    // a chunk that lost a row leaves the main, readers must not read its compressed copy or its trees meanwhile
+    std::unique_lock<std::shared_mutex> lock(main_mutex);
+    const std::size_t num_chunks = std::min(merged_chunks.load(), num_rows / chunk_rows_);
+    if(num_chunks == merged_chunks.load()) return;
+    for(auto &chunks : compressed) {
+        if(chunks.size() > num_chunks) chunks.resize(num_chunks);
+    }
+    for(auto &index : indexes) index.trees.resize(num_chunks);
+    std::lock_guard<std::mutex> merge_lock(merge_mutex);
+    merged_chunks.store(num_chunks);
+    requested_chunks = merge_target = num_chunks;
+}
+
+std::size_t ColumnMain::compressed_size_in_bytes() const
+{
+    std::shared_lock<std::shared_mutex> lock(main_mutex);
+    std::size_t size = 0;
+    for(auto &chunks : compressed) {
+        for(auto &chunk : chunks) size += chunk.size_in_bytes();
+    }
+    return size;
+}
+
+std::size_t ColumnMain::uncompressed_size_in_bytes() const
+{
+    std::shared_lock<std::shared_mutex> lock(main_mutex);
+    std::size_t size = 0;
+    for(uint32_t x = 0; x < columns.size(); x++) {
+        size += compressed.at(x).size() * bytes_of(x, chunk_rows_);
+    }
+    return size;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "BPlusTree.hpp"
+#include "ColumnCodec.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+
+/*
+ * Read-optimized main of a column store.
+ * The rows of the store are split into chunks of `chunk_rows()` rows.  Chunks that filled up are merged into the
+ * main, i.e. sorted by the sort key, if any, indexed by the secondary indexes and, if enabled, compressed; the rows
+ * after them form the write-optimized delta.  The store hands chunks to merging on append, and they are merged right
+ * away or by a background thread.  Rows of the main and of the delta are read in place.
+ */
+struct ColumnMain
+{
+    /** Memory of a column of the store, which is never moved. */
+    struct column
+    {
+        char *data;
+        std::size_t stride; // bytes per row, per `packed_rows` rows of a bit-packed column
+        std::size_t packed_rows; // rows sharing the bytes of a stride
+        bool integral; // enables BITPACK compression
+    };
+    using index_type = BPlusTree<int64_t, uint32_t>;
+
+    /** Sort key of a main whose rows are kept in the order they were appended. */
+    static constexpr std::size_t NO_SORT_KEY = ~std::size_t(0);
+
+    private:
+    struct secondary_index
+    {
+        std::size_t attr;
+        std::vector<std::unique_ptr<index_type>> trees; // one per chunk of the main
+    };
+
+    std::vector<column> columns; // the last one holds the null bitmaps
+    const std::size_t chunk_rows_;
+    bool compression = false; // whether merged chunks are compressed
+    std::vector<std::vector<CompressedChunk>> compressed; // compressed copies of the chunks of the main
+    std::size_t sort_key = NO_SORT_KEY; // column by which the rows of every chunk of the main are sorted
+    std::vector<secondary_index> indexes;
+    std::atomic<std::size_t> merged_chunks{0}; // chunks of every column in the main
+    std::size_t requested_chunks = 0; // chunks handed to merging, only used by the writer
+    std::thread merger; // merges chunks in the background, if started
+    std::mutex merge_mutex; // protects the following two members
+    std::condition_variable merge_wake, merge_done;
+    std::size_t merge_target = 0; // chunks the merger merges
+    bool stop_merging = false;
+    mutable std::shared_mutex main_mutex; // held exclusively while the main changes, shared while reading it
+
+    /** Returns the number of bytes of the first `num_rows` rows of the column with index `x`. */
+    std::size_t bytes_of(std::size_t x, std::size_t num_rows) const {
+        return (num_rows + columns[x].packed_rows - 1) / columns[x].packed_rows * columns[x].stride;
+    }
+    /** Returns the value of the integral column with index `attr` in `row`. */
+    int64_t integer_at(std::size_t attr, std::size_t row) const;
+    /** Returns true iff the column with index `attr` is NULL in `row`. */
+    bool is_null(std::size_t attr, std::size_t row) const;
+    /** Sorts the rows of the chunk with index `chunk` by the sort key, NULLs last, keeping the order of equal rows. */
+    void sort(std::size_t chunk);
+    /** Bulkloads the tree of `index` over the chunk with index `chunk`. */
+    void build(secondary_index &index, std::size_t chunk);
+    /** Compresses the chunk with index `chunk` of every column. */
+    void seal(std::size_t chunk);
+    /** Sorts, indexes and compresses the chunk with index `chunk`, the first chunk after the main, into the main. */
+    void merge_chunk(std::size_t chunk);
+
+    public:
+    ColumnMain(std::size_t chunk_rows) : chunk_rows_(chunk_rows) { }
+    /** Stops the background merge, chunks that are not merged yet are left in the delta. */
+    ~ColumnMain();
+
+    /** Describes the memory of the store, every column and finally the null bitmaps. */
+    void describe(std::vector<column> columns) {
+        this->columns = std::move(columns);
+        compressed.resize(this->columns.size());
+    }
+
+    std::size_t chunk_rows() const { return chunk_rows_; }
+    /** Returns the number of rows of all chunks of the main. */
+    std::size_t sealed_rows() const { return merged_chunks.load() * chunk_rows_; }
+    /** Returns the number of chunks handed to merging, which the main holds once they are merged. */
+    std::size_t requested() const { return requested_chunks; }
+
+    /** Keeps a compressed copy of every chunk of the main, see `chunks()`.  Must be called before a chunk is handed
+     * to merging. */
+    void enable_compression();
+    /** Keeps the rows of every chunk of the main sorted by the integral column with index `attr`, NULLs last.  Must be
+     * called before a chunk is handed to merging. */
+    void sort_by(std::size_t attr);
+    /** Returns the sort key, or `NO_SORT_KEY`. */
+    std::size_t sort_column() const { return sort_key; }
+    /** Maintains a secondary index that maps the values of the integral column with index `attr` to row ids, with a
+     * tree per chunk of the main that is bulkloaded when the chunk is merged. */
+    void add_index(std::size_t attr);
+    /** Returns the number of secondary indexes. */
+    std::size_t num_indexes() const { return indexes.size(); }
+    /** Returns the tree of the secondary index of the column with index `attr` over the chunk with index `chunk` of
+     * the main.  It stays valid until the chunk is truncated, so it must not be used concurrently with `truncate()`. */
+    const index_type & index(std::size_t attr, std::size_t chunk) const;
+    /** Calls `callback(row)` for every row of the first `num_rows` rows whose value of the integral column with index
+     * `attr` is at least `lower` and less than `upper`.  The chunks of the main are searched through the secondary
+     * index of `attr` or by binary search if `attr` is the sort key, in the order of the values per chunk; the rows of
+     * the delta are filtered in row order.  May be called concurrently. */
+    void in_range(std::size_t attr, int64_t lower, int64_t upper, std::size_t num_rows,
+                  const std::function<void(std::size_t)> &callback) const;
+    /** Calls `callback(values, num_rows)` for consecutive runs of the first `num_rows` rows of the column with index
+     * `attr`, in row order.  Compressed chunks are decompressed, all other rows are passed as they are.  A chunk is
+     * not merged while it is scanned. */
+    void scan(std::size_t attr, std::size_t num_rows,
+              const std::function<void(const char*, std::size_t)> &callback) const;
+
+    /** Merges the chunks handed to merging in a background thread from now on. */
+    void merge_in_background();
+    /** Hands the chunks before the chunk with index `num_chunks` to merging, all their rows must be written.  Without
+     * a background merge, they are merged before returning. */
+    void merge(std::size_t num_chunks);
+    /** Waits until the background merge merged every chunk handed to it. */
+    void wait();
+    /** Moves the chunks that are no longer complete after the store shrank to `num_rows` rows back to the delta.  The
+     * background merge must be idle. */
+    void truncate(std::size_t num_rows);
+
+    /** Returns the compressed copies of the chunks of the main of the column with index `attr`, none unless
+     * compression is enabled.  With a background merge, only valid after `wait()`. */
+    const std::vector<CompressedChunk> & chunks(std::size_t attr) const { return compressed.at(attr); }
+    /** Returns the number of bytes of all compressed copies. */
+    std::size_t compressed_size_in_bytes() const;
+    /** Returns the number of bytes of the chunks that have a compressed copy. */
+    std::size_t uncompressed_size_in_bytes() const;
+};
@@ -3,31 +3,118 @@ Implementation of column store
 */
 
 #include "ColumnStore.hpp"
+#include <algorithm>
+#include <string>
 
 
-ColumnStore::ColumnStore(const m::Table &table)
+ColumnStore::ColumnStore(const m::Table &table, AllocationPolicy policy, std::size_t reservation)
     : Store(table)
+    , zones(table)
+    , main(COMPRESSION_CHUNK_ROWS)
 {
     /*Allocate columns for the attributes. */
     rows = 0;
-    capacity = 8;
-    this->table = &table;
+    capacity = 0;
+    max_rows = RowLimit(table, reservation);
+    this->column_table = &table;
 
-    uint32_t sizeOfAttr = 0;
     for (auto it = table.begin(); it != table.end(); it++) {
-        sizeOfAttr = (*it).type->size();
+        // every row of a column occupies whole bytes, booleans are bit-packed
+        std::size_t stride = ((*it).type->size() + 7) / 8;
+        std::size_t values = (*it).type->is_boolean() ? PACKED_ROWS : 1;
 
-        // allocate 8 "rows" for the current column
-        char* ptr = (char*) malloc(std::ceil(capacity * sizeOfAttr / 8.0f));  
-
-        // add current column to vector of all columns
-        columns.push_back(ptr);
-        sizeOfAttrs.push_back(sizeOfAttr);
+        // reserve address space for the column, chunks are committed on append
+        columns.emplace_back(CHUNK_SIZE, (max_rows + values - 1) / values * stride, policy);
     }
     /*Allocate a column for the null bitmap. */
-    char* nullBitMap = (char*) malloc(std::ceil(capacity * table.size() / 8.0f));
-    columns.push_back(nullBitMap);
-    sizeOfAttrs.push_back(table.size());
+    columns.emplace_back(CHUNK_SIZE, max_rows * ((table.size() + 7) / 8), policy);
+
+    initialize();
+}
+
+ColumnStore::ColumnStore(const m::Table &table, const char *filename, std::size_t reservation)
+    : Store(table)
+    , zones(table)
+    , main(COMPRESSION_CHUNK_ROWS)
+{
+    rows = 0;
+    capacity = 0;
+    max_rows = RowLimit(table, reservation);
+    this->column_table = &table;
+
+    /*Map a file for every column, the null bitmap and the header share the file `filename`. */
+    for (std::size_t i = 0; i != table.size(); ++i) {
+        std::size_t stride = (table[i].type->size() + 7) / 8;
+        std::size_t values = table[i].type->is_boolean() ? PACKED_ROWS : 1;
+        columns.emplace_back((std::string(filename) + "." + std::to_string(i)).c_str(), 0, CHUNK_SIZE,
+                             (max_rows + values - 1) / values * stride);
+    }
+    columns.emplace_back(filename, StoreFileHeader::SIZE, CHUNK_SIZE, max_rows * ((table.size() + 7) / 8));
+
+    /*Check that the files hold columns of the same layout. */
+    uint64_t layout = StoreFileHeader::Fingerprint(StoreFileHeader::EMPTY_LAYOUT, PACKED_ROWS);
+    for (auto &attr : table) {
+        layout = StoreFileHeader::Fingerprint(layout, attr);
+    }
+    fileHeader = &StoreFileHeader::Open(columns.back().header_data(), StoreFileHeader::COLUMN_STORE, table.size(),
+                                        layout, filename);
+    rows = fileHeader->num_rows;
+    if(rows > max_rows) {
+        std::cout << "Error in ColumnStore: file " << filename << " holds " << rows << " rows, more than the limit of "
+                  << max_rows << " rows" << "\n";
+        exit(1);
+    }
+
+    initialize();
+}
+
+std::size_t ColumnStore::RowLimit(const m::Table &table, std::size_t reservation)
+{
+    // bits of every row in all columns, booleans take a single bit and every row has a null bitmap
+    std::size_t row_bits = (table.size() + 7) / 8 * 8;
+    for (auto &attr : table) {
+        row_bits += attr.type->is_boolean() ? 1 : (attr.type->size() + 7) / 8 * 8;
+    }
+    return std::max<std::size_t>(1, std::min(MAX_ROWS, reservation / row_bits * 8));
+}
+
+void ColumnStore::initialize()
+{
+    for (auto &attr : *column_table) {
+        sizeOfAttrs.push_back(attr.type->size());
+        strides.push_back((attr.type->size() + 7) / 8);
+        packed_rows.push_back(attr.type->is_boolean() ? PACKED_ROWS : 1);
+    }
+    sizeOfAttrs.push_back(column_table->size());
+    strides.push_back((column_table->size() + 7) / 8);
+    packed_rows.push_back(1);
+
+    /*Commit the first chunk of every column, or all chunks holding rows of a reopened store. */
+    capacity = max_rows;
+    for (uint32_t x = 0; x < columns.size(); x++) {
+        columns.at(x).reserve(bytes_of(x, std::max<std::size_t>(rows, 1)));
+        capacity = std::min(capacity, rows_in(x, columns.at(x).size()));
+    }
+
+    /*Describe the columns to snapshots. */
+    std::vector<SnapshotRegistry::arena> arenas;
+    std::vector<std::pair<std::size_t, AttributeLayout>> attributes;
+    for (uint32_t x = 0; x < columns.size(); x++) {
+        arenas.push_back({ columns.at(x).data(), SNAPSHOT_SEGMENT_ROWS, bytes_of(x, SNAPSHOT_SEGMENT_ROWS) });
+        attributes.emplace_back(x, AttributeLayout{ nullptr, packed_rows.at(x), strides.at(x), 0,
+                                                    packed_rows.at(x) > 1 ? 1u : 0u });
+    }
+    snapshots.describe(std::move(arenas), std::move(attributes));
+    snapshots.publish(rows);
+
+    /*Describe the columns to the main, compressed chunks of integral columns are bit-packed. */
+    std::vector<ColumnMain::column> main_columns;
+    for (uint32_t x = 0; x < columns.size(); x++) {
+        const bool is_attr = x < column_table->size();
+        main_columns.push_back({ columns.at(x).data(), strides.at(x), packed_rows.at(x),
+                                 is_attr && column_table->at(x).type->is_integral() });
+    }
+    main.describe(std::move(main_columns));
 
     /*Create linearization.*/
     createLinearization();
@@ -36,16 +123,20 @@ ColumnStore::ColumnStore(const m::Table &table)
 void ColumnStore::createLinearization() {
     auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(columns.size()));
     size_t i = 0;
+    // every child covers PACKED_ROWS rows, a bit-packed column stores them one bit apart in a single byte
     while (i < columns.size() - 1) {
-        auto col = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
-        col->add_sequence(0, 0, table->at(i));
-        lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(columns.at(i))), sizeOfAttrs[i] / 8, std::move(col));
+        const bool packed = packed_rows[i] > 1;
+        auto col = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, PACKED_ROWS));
+        col->add_sequence(0, packed ? 1 : strides[i] * 8, column_table->at(i));
+        lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(columns.at(i).data())),
+                          packed ? strides[i] : strides[i] * PACKED_ROWS, std::move(col));
         i++;
     }
     // null bitmap
-    auto null_bm = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, 1));
-    null_bm->add_null_bitmap(0, 0);
-    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(columns.at(i))), sizeOfAttrs[i], std::move(null_bm));
+    auto null_bm = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(1, PACKED_ROWS));
+    null_bm->add_null_bitmap(0, strides[i] * 8);
+    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(columns.at(i).data())), strides[i] * PACKED_ROWS,
+                      std::move(null_bm));
 
     // set the linearization
     linearization(std::move(lin));
@@ -54,14 +145,12 @@ void ColumnStore::createLinearization() {
 
 ColumnStore::~ColumnStore()
 {
-    // free the memory of every column
-    for(uint32_t x = 0; x < columns.size(); x++) {
-        free(columns.at(x));
-    }
+    // the main stops merging, chunks that are not merged yet are left in the delta
+    // the memory of every column is freed by its arena
 
     // reset fields
     rows = 0;
-    capacity = 8;
+    capacity = 0;
 
     return;
 }
@@ -71,53 +160,191 @@ std::size_t ColumnStore::num_rows() const
     return rows;
 }
 
-void ColumnStore::append()
+void ColumnStore::grow(std::size_t n)
 {
+    // every row before the new ones has been written, seal the chunks and blocks that filled up
+    seal_written();
+    snapshots.publish(published_rows());
+
     // check whether allocated memory is full
-    if(rows == capacity) {
-        capacity *= 2;
-        bool failed = false;
-        // allocate more memory for the columns
-        for(uint32_t x = 0; x < columns.size(); x++) {
-            columns.at(x) = (char*) realloc(columns.at(x), std::ceil(capacity * sizeOfAttrs.at(x) / 8.0f));
-            if (columns.at(x) == NULL) {
-                std::cout << "could not reallocate memory in ColumnStore::append().." << std::endl;
-                failed = true;
-            }
-        }
-        if(failed) {
-            this->~ColumnStore();
-            exit(1);
-        }
-        //create new Linearization
-        createLinearization();
+    if(rows + n > capacity) {
+        reserve(rows + n);
     }
-    // add row 
-    rows++;
+    // rows dropped while pinned are only overwritten once no reader may read them in place
+    snapshots.before_write(rows, n);
+    // add rows
+    rows += n;
+    if(fileHeader) fileHeader->num_rows = rows;
+}
 
-    return;
+void ColumnStore::seal_written()
+{
+    const std::size_t full_chunks = rows / COMPRESSION_CHUNK_ROWS;
+    // log the written rows in batches, and in the order they were appended before their chunk is sorted
+    if(redo && (redo->num_unlogged(rows) >= StoreLog::BATCH_ROWS ||
+                (sort_column() != NO_SORT_KEY && main.requested() < full_chunks))) {
+        redo->log_rows(layouts(), rows);
+    }
+
+    // sorting moves rows, also rows dropped while pinned that readers may still read in place
+    if(sort_column() != NO_SORT_KEY && main.requested() < full_chunks) {
+        snapshots.before_write(main.requested() * COMPRESSION_CHUNK_ROWS,
+                               (full_chunks - main.requested()) * COMPRESSION_CHUNK_ROWS);
+    }
+    main.merge(full_chunks);
+
+    // with a sort key, a block is summarized once its rows are sorted
+    while((zones.num_blocks() + 1) * zones.block_rows() <= published_rows()) {
+        zones.seal([this](std::size_t attr, std::size_t row) {
+            return std::make_pair<const char*, std::size_t>(
+                columns[attr].data() + row / packed_rows[attr] * strides[attr], row % packed_rows[attr]);
+        });
+    }
+}
+
+void ColumnStore::merge()
+{
+    seal_written();
+    main.wait();
+}
+
+void ColumnStore::reserve(std::size_t num_rows)
+{
+    if(num_rows > max_rows) {
+        std::cout << "Error in ColumnStore::reserve: " << num_rows << " rows exceed the limit of " << max_rows
+                  << " rows" << "\n";
+        exit(1);
+    }
+    // commit the next chunks of every column that is too small; no column is copied or moved, so the linearization
+    // stays valid
+    std::size_t new_capacity = max_rows;
+    for(uint32_t x = 0; x < columns.size(); x++) {
+        columns.at(x).reserve(bytes_of(x, num_rows));
+        new_capacity = std::min(new_capacity, rows_in(x, columns.at(x).size()));
+    }
+    capacity = new_capacity;
+}
+
+void ColumnStore::append()
+{
+    grow(1);
+}
+
+RowRange ColumnStore::append(std::size_t n)
+{
+    RowRange range{ rows, n, layouts() };
+    grow(n);
+    return range;
+}
+
+void ColumnStore::attach_log(WriteAheadLog &log, uint32_t id)
+{
+    std::vector<std::size_t> sizes;
+    for(auto &attr : *column_table) {
+        sizes.push_back(attr.type->size());
+    }
+    StoreLog::Replay(log, id, sizes, rows,
+                     [this](std::size_t n) { return append(n); },
+                     [this](std::size_t n) { while(rows > n) drop(); },
+                     [this]() { return layouts(); });
+    redo = std::make_unique<StoreLog>(log, id, std::move(sizes), rows);
+}
+
+void ColumnStore::commit()
+{
+    if(redo) redo->commit(layouts(), rows);
+}
+
+std::vector<AttributeLayout> ColumnStore::layouts() const
+{
+    // every block is a single value of a column, or PACKED_ROWS values one bit apart
+    std::vector<AttributeLayout> result;
+    for(uint32_t x = 0; x < columns.size(); x++) {
+        result.push_back(AttributeLayout{ columns.at(x).data(), packed_rows.at(x), strides.at(x), 0,
+                                          packed_rows.at(x) > 1 ? 1u : 0u });
+    }
+    return result;
 }
 
 void ColumnStore::drop()
 {
+    // with a sort key, the last row is the last one of its sorted chunk, so chunks that filled up are sorted first
+    if(sort_column() != NO_SORT_KEY) seal_written();
+    // the main only changes while the background merge is idle
+    main.wait();
+
     // check whether there are any rows to drop
     if(rows > 0) rows--;
+    if(fileHeader) fileHeader->num_rows = rows;
+
+    // a chunk or block that lost a row is no longer sealed
+    const std::size_t sealed = main.sealed_rows();
+    main.truncate(rows);
+    zones.truncate(published_rows());
+    if(redo) redo->log_truncate(rows);
+
+    snapshots.preserve(rows);
+    if(sort_column() != NO_SORT_KEY && main.sealed_rows() < sealed) {
+        // the chunk is sorted again once it fills up, which may move any of its rows
+        for(std::size_t first = rows - rows % SNAPSHOT_SEGMENT_ROWS; first > main.sealed_rows(); ) {
+            first -= SNAPSHOT_SEGMENT_ROWS;
+            snapshots.preserve(first);
+        }
+    }
+
+    // return unused chunks of every column to the OS once the table shrank enough and no reader may read them
+    bool trimmed = false;
+    const bool unread = snapshots.quiescent();
+    for(uint32_t x = 0; x < columns.size() && unread; x++) {
+        trimmed |= columns.at(x).trim(bytes_of(x, rows));
+    }
+    if(trimmed) {
+        capacity = max_rows;
+        for(uint32_t x = 0; x < columns.size(); x++) {
+            capacity = std::min(capacity, rows_in(x, columns.at(x).size()));
+        }
+    }
 
     // remove row
     return;
 }
 
+void ColumnStore::sync()
+{
+    for(auto &column : columns) {
+        column.sync();
+    }
+}
+
+void ColumnStore::sort_by(std::size_t attr)
+{
+    if(not snapshots.empty()) {
+        std::cout << "Error in ColumnStore::sort_by: the store has pinned snapshots" << "\n";
+        exit(1);
+    }
+    main.sort_by(attr);
+    // rows that are not sorted yet are neither summarized nor visible to snapshots
+    zones.truncate(0);
+    snapshots.publish(0);
+}
+
 void ColumnStore::dump(std::ostream &out) const
 {
     /*Print description of this store to `out`.*/
-    int x = 0;
-    for(auto &size:sizeOfAttrs){
-        printf("Size of the %d. attribute: %d - address : %s \n", x+1, size, columns.at(x));
-        x++;
+    for(uint32_t x = 0; x < sizeOfAttrs.size(); x++){
+        out << "Size of the " << x+1 << ". attribute: " << sizeOfAttrs.at(x) << " bits - "
+            << columns.at(x).num_blocks() << " chunks at " << static_cast<const void*>(columns.at(x).data()) << "\n";
     }
 
     out << "\n\n";
     out << rows << " rows in use and " << capacity << " rows are allocated." << std::endl;
+    out << "Sealed chunks take " << compressed_size_in_bytes() << " bytes compressed and "
+        << uncompressed_size_in_bytes() << " bytes uncompressed." << std::endl;
+    out << "Zone maps cover " << zones.num_blocks() << " blocks of " << zones.block_rows() << " rows." << std::endl;
+    if(sort_column() != NO_SORT_KEY) {
+        out << "Sealed chunks are sorted by the " << sort_column() + 1 << ". attribute." << std::endl;
+    }
+    out << main.num_indexes() << " columns have a secondary index." << std::endl;
     out.flush();
     return;
-}
\ No newline at end of file
+}
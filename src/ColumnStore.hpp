@@ -1,5 +1,15 @@
 #pragma once
 
+#include "BlockArena.hpp"
+#include "ColumnMain.hpp"
+#include "RowRange.hpp"
+#include "Snapshot.hpp"
+#include "StoreFile.hpp"
+#include "WriteAheadLog.hpp"
+#include "ZoneMap.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <mutable/mutable.hpp>
 
 
@@ -7,17 +17,151 @@ struct ColumnStore : m::Store
 {
     private:
     /*Declare necessary fields. */
-    std::size_t rows, capacity;
-    std::vector<char*> columns; // stores pointers of the columns
+    std::atomic<std::size_t> rows; // readers of the main may read it while rows are appended
+    std::size_t capacity;
+    std::size_t max_rows; // rows that fit into the address space reserved for every column
+    std::vector<BlockArena> columns; // stores the columns, each one grown chunk by chunk
     std::vector<uint32_t> sizeOfAttrs; // stores sizes of the attributes as given from the table
-    const m::Table *table;
+    std::vector<std::size_t> strides; // bytes per row of every column, per PACKED_ROWS rows of a bit-packed column
+    std::vector<std::size_t> packed_rows; // rows sharing the bytes of a stride, PACKED_ROWS for booleans and 1 otherwise
+    const m::Table *column_table;
+    ZoneMap zones; // min/max and null count of every column per block of rows
+    StoreFileHeader *fileHeader = nullptr; // header of the file of a persistent store
+    SnapshotRegistry snapshots; // snapshots pinning rows, in segments of SNAPSHOT_SEGMENT_ROWS rows of every column
+    std::unique_ptr<StoreLog> redo; // redo logging of the rows, if the store is attached to a log
+    /* The sealed chunks form the read-optimized main, the rows after them the write-optimized delta.  The main is
+     * destroyed first, so that a background merge stops before the columns are released. */
+    ColumnMain main;
+
+    void initialize();
+    /** Returns the number of bytes of the first `num_rows` rows of the column with index `x`. */
+    std::size_t bytes_of(std::size_t x, std::size_t num_rows) const {
+        return (num_rows + packed_rows[x] - 1) / packed_rows[x] * strides[x];
+    }
+    /** Returns the number of rows that fit into `bytes` bytes of the column with index `x`. */
+    std::size_t rows_in(std::size_t x, std::size_t bytes) const { return bytes / strides[x] * packed_rows[x]; }
+
+    /** Returns the number of rows visible to new snapshots; with a sort key, rows are visible once they are sorted. */
+    std::size_t published_rows() const { return sort_column() == NO_SORT_KEY ? rows.load() : main.sealed_rows(); }
+    /** Merges the chunks and seals the blocks that filled up, all rows must be written. */
+    void seal_written();
+    void grow(std::size_t n);
+    /** Returns the number of rows of `table` that fit into `reservation` bytes of address space, at most `MAX_ROWS`. */
+    static std::size_t RowLimit(const m::Table &table, std::size_t reservation);
 
     public:
-    ColumnStore(const m::Table &table);
+    /** Creates a store whose columns together reserve `reservation` bytes of address space, see `row_limit()`. */
+    ColumnStore(const m::Table &table, AllocationPolicy policy = AllocationPolicy(),
+                std::size_t reservation = BlockArena::DEFAULT_RESERVATION);
+    /** Creates a persistent store, or reopens the rows stored by a store of a table with the same layout.  The file
+     * `filename` holds a header and the null bitmaps, the column with index `i` is kept in the file `filename.i`.
+     * Chunks and zone maps of reopened rows are built when the next row is appended. */
+    ColumnStore(const m::Table &table, const char *filename,
+                std::size_t reservation = BlockArena::DEFAULT_RESERVATION);
     ~ColumnStore();
 
     void createLinearization();
 
+    /** Row ids are 32 bits wide, so a store holds at most this many rows. */
+    static constexpr std::size_t MAX_ROWS = std::size_t(1) << 31;
+    /** Size of a column chunk in bytes. */
+    static constexpr std::size_t CHUNK_SIZE = BlockArena::DEFAULT_BLOCK_SIZE;
+    /** Boolean columns are bit-packed, a byte holds the values of this many consecutive rows. */
+    static constexpr std::size_t PACKED_ROWS = 8;
+    /** Number of rows of a chunk of the main.  A chunk is merged once the row following it is appended. */
+    static constexpr std::size_t COMPRESSION_CHUNK_ROWS = 1 << 16;
+    /** Number of rows of every column that a snapshot copies at once when rows it sees are dropped. */
+    static constexpr std::size_t SNAPSHOT_SEGMENT_ROWS = 1 << 12;
+    static_assert(SNAPSHOT_SEGMENT_ROWS % PACKED_ROWS == 0, "segments must not split the bytes of bit-packed columns");
+
+    /** Sort key of a store whose rows are kept in the order they were appended. */
+    static constexpr std::size_t NO_SORT_KEY = ColumnMain::NO_SORT_KEY;
+    static_assert(COMPRESSION_CHUNK_ROWS % SNAPSHOT_SEGMENT_ROWS == 0, "a chunk is sorted segment by segment");
+    using index_type = ColumnMain::index_type;
+
+    /** Keeps the rows of every sealed chunk sorted by the integral column with index `attr`, NULLs last.  Rows are
+     * sorted when their chunk is sealed and only then become visible to snapshots.  Dropping rows removes the last
+     * rows of the sorted chunk, so rows must be written before they are dropped.  Must be called before a chunk is
+     * sealed and while no snapshot is pinned. */
+    void sort_by(std::size_t attr);
+    /** Returns the sort key, or `NO_SORT_KEY`. */
+    std::size_t sort_column() const { return main.sort_column(); }
+    /** Maintains a secondary index that maps the values of the integral column with index `attr` to row ids. */
+    void add_index(std::size_t attr) { main.add_index(attr); }
+    /** Returns the secondary index of the column with index `attr` over the sealed chunk with index `chunk`, see
+     * `ColumnMain::index()`. */
+    const index_type & index(std::size_t attr, std::size_t chunk) const { return main.index(attr, chunk); }
+    /** Calls `callback(row)` for every row whose value of the integral column with index `attr` is at least `lower`
+     * and less than `upper`, through its secondary index or the sort key if possible, see `ColumnMain::in_range()`. */
+    void in_range(std::size_t attr, int64_t lower, int64_t upper, const std::function<void(std::size_t)> &callback) {
+        main.in_range(attr, lower, upper, rows, callback);
+    }
+
+    /** Calls `callback(values, num_rows)` for consecutive runs of the column with index `attr`, in row order.
+     * `values` holds `num_rows` values of `stride(attr)` bytes, or `values_per_stride(attr)` bit-packed values per
+     * byte; compressed copies of sealed chunks are decompressed, all other rows are passed as they are.
+     * A chunk is not merged while it is scanned.  The index `table.size()` refers to the null bitmap. */
+    void scan(std::size_t attr, const std::function<void(const char*, std::size_t)> &callback) const {
+        main.scan(attr, rows, callback);
+    }
+    /** Returns the zone maps of the sealed blocks of rows, used by scans to skip blocks. */
+    const ZoneMap & zone_map() const { return zones; }
+    /** Returns the number of bytes of every value of the column with index `attr`, or of `values_per_stride(attr)`
+     * values of a bit-packed column. */
+    std::size_t stride(std::size_t attr) const { return strides.at(attr); }
+    /** Returns the number of values sharing `stride(attr)` bytes of the column with index `attr`, which is greater
+     * than 1 for bit-packed columns. */
+    std::size_t values_per_stride(std::size_t attr) const { return packed_rows.at(attr); }
+    /** Merges chunks that fill up in a background thread instead of on append, so that appending rows never waits
+     * for sorting and compressing a chunk.  With a sort key, rows must only be read in place after `merge()`. */
+    void merge_in_background() { main.merge_in_background(); }
+    /** Merges every chunk that filled up into the main and waits for the background merge to finish.  All rows must
+     * be written. */
+    void merge();
+
+    /** Keeps a compressed copy of every sealed chunk in addition to the columns, so that the compression ratio of the
+     * data can be inspected; scans decompress them instead of reading the chunks in place.  The copies take memory
+     * on top of the columns.  Must be called before a chunk is sealed. */
+    void enable_compression() { main.enable_compression(); }
+    /** Returns the compressed copies of the sealed chunks of the column with index `attr`, none unless compression is
+     * enabled.  With a background merge, only valid after `merge()`. */
+    const std::vector<CompressedChunk> & chunks(std::size_t attr) const { return main.chunks(attr); }
+    /** Returns the number of bytes of all compressed copies. */
+    std::size_t compressed_size_in_bytes() const { return main.compressed_size_in_bytes(); }
+    /** Returns the number of bytes of all sealed chunks that have a compressed copy. */
+    std::size_t uncompressed_size_in_bytes() const { return main.uncompressed_size_in_bytes(); }
+
+    /** Returns the location of every column, the last one holding the null bitmaps. */
+    std::vector<AttributeLayout> layouts() const;
+    /** Returns the number of rows the store can hold at most. */
+    std::size_t row_limit() const { return max_rows; }
+    /** Commits memory for `num_rows` rows in total, so that appending up to that many rows never grows the store.
+     * Exceeding `row_limit()` is an error. */
+    void reserve(std::size_t num_rows);
+    /** Appends `n` rows at once and returns them for writing. */
+    RowRange append(std::size_t n);
+
+    /** Replays the rows logged for the store with id `id` in `log`, and logs all later appends and drops there.
+     * Rows the store holds already, e.g. a reopened persistent store, are not replayed. */
+    void attach_log(WriteAheadLog &log, uint32_t id = 0);
+    /** Waits until all rows appended so far are durable in the attached log.  Rows that are not committed are lost
+     * in a crash. */
+    void commit();
+
+    /** Returns a consistent view of the rows written so far, which other threads may read while rows are appended
+     * and dropped.  Appending rows that no snapshot has seen never waits for readers. */
+    Snapshot snapshot() { return snapshots.pin(); }
+    /** Makes all appended rows visible to new snapshots.  Otherwise rows become visible once the next row is
+     * appended, since they are written after `append()` returns.  With a sort key, only sorted rows become visible. */
+    void publish() { snapshots.publish(published_rows()); }
+
+    /** Returns the number of rows that fit into the committed chunks of every column. */
+    std::size_t allocated_rows() const { return capacity; }
+    /** Returns true iff the columns are kept in files. */
+    bool is_persistent() const { return fileHeader != nullptr; }
+    /** Writes the columns of a persistent store back to their files and waits for completion. */
+    void sync();
+
     std::size_t num_rows() const override;
     void append() override;
     void drop() override;
@@ -0,0 +1,186 @@
+/*
+Header file for an open addressing hash index
+Refer the "Swiss table" design of Abseil's flat_hash_map
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * The hash index only answers point lookups and offers the same `Bulkload` and `find` surface as `BPlusTree`.
+ * All entries are kept in an array, in the order they were bulkloaded.  The hash table maps every distinct key to the
+ * position of its first entry in that array, hence `find` returns the first entry with the key, like `BPlusTree`.
+ *
+ * The table uses open addressing.  Next to the slots, the table keeps one metadata byte per slot: either `EMPTY` or
+ * the 7 low bits of the hash of the key in that slot.  A probe compares the metadata of a whole group of slots at
+ * once, and only touches the slots whose metadata matches.  A probe for a missing key usually ends after inspecting a
+ * single group of metadata bytes.
+ */
+template<
+    typename Key,
+    typename Value>
+struct HashIndex
+{
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+
+    private:
+    static constexpr size_type GROUP_SIZE = 16; ///< number of metadata bytes probed at once
+    static constexpr int8_t EMPTY = -128; ///< metadata of an empty slot, all hash metadata is non-negative
+
+    struct slot
+    {
+        key_type key;
+        size_type index; ///< position of the first entry with `key`
+    };
+
+    /*
+     * Declare fields of the hash index.
+     */
+    std::vector<value_type> entries;
+    std::vector<int8_t> metadata; ///< capacity + GROUP_SIZE bytes, the first group is mirrored at the end
+    std::vector<slot> slots;
+    size_type mask; ///< capacity - 1, the capacity is a power of two
+
+    static uint64_t hash(key_type key) {
+        /* finalizer of MurmurHash3 */
+        uint64_t h = uint64_t(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+    static size_type H1(uint64_t h) { return size_type(h >> 7); }
+    static int8_t H2(uint64_t h) { return int8_t(h & 0x7f); }
+
+    /** Returns a bitmask of the slots in the group at `pos` whose metadata equals `m`. */
+    uint32_t match(size_type pos, int8_t m) const {
+#ifdef __SSE2__
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(metadata.data() + pos));
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(m), group)));
+#else
+        uint32_t bits = 0;
+        for (size_type i = 0; i != GROUP_SIZE; ++i)
+            bits |= uint32_t(metadata[pos + i] == m) << i;
+        return bits;
+#endif
+    }
+
+    void set_metadata(size_type i, int8_t m) {
+        metadata[i] = m;
+        if (i < GROUP_SIZE) metadata[mask + 1 + i] = m; // mirror the first group
+    }
+
+    void insert(key_type key, size_type index) {
+        const uint64_t h = hash(key);
+        size_type pos = H1(h) & mask;
+        for (size_type step = 1; ; ++step) {
+            if (uint32_t empty = match(pos, EMPTY)) {
+                const size_type i = (pos + __builtin_ctz(empty)) & mask;
+                set_metadata(i, H2(h));
+                slots[i] = slot{ key, index };
+                return;
+            }
+            pos = (pos + step * GROUP_SIZE) & mask; // triangular probing visits every group
+        }
+    }
+
+    /** Returns the position of the first entry with `key`, or `entries.size()` if no such entry exists. */
+    size_type lookup(key_type key) const {
+        if (slots.empty()) return entries.size();
+        const uint64_t h = hash(key);
+        const int8_t m = H2(h);
+        size_type pos = H1(h) & mask;
+        for (size_type step = 1; ; ++step) {
+            for (uint32_t candidates = match(pos, m); candidates; candidates &= candidates - 1) {
+                const slot &s = slots[(pos + __builtin_ctz(candidates)) & mask];
+                if (s.key == key) return s.index;
+            }
+            if (match(pos, EMPTY)) return entries.size(); // the key would have been placed in this group
+            pos = (pos + step * GROUP_SIZE) & mask;
+        }
+    }
+
+    /*--- Start of hash index code -----------------------------------------------------------------------------------*/
+    public:
+    /** Bulkloads the entries in [`begin`, `end`).  Entries with equal keys must be adjacent. */
+    template<typename It>
+    static HashIndex Bulkload(It begin, It end) {
+        HashIndex index;
+        for (auto i = begin; i != end; ++i)
+            index.entries.emplace_back(i->first, i->second);
+
+        size_type num_keys = 0;
+        for (size_type i = 0; i != index.entries.size(); ++i)
+            num_keys += i == 0 or index.entries[i - 1].first != index.entries[i].first;
+        if (num_keys == 0) return index;
+
+        /* keep the load factor at most 7/8 */
+        size_type capacity = GROUP_SIZE;
+        while (capacity * 7 / 8 < num_keys) capacity *= 2;
+        index.mask = capacity - 1;
+        index.metadata.assign(capacity + GROUP_SIZE, EMPTY);
+        index.slots.resize(capacity);
+
+        for (size_type i = 0; i != index.entries.size(); ++i) {
+            const key_type key = index.entries[i].first;
+            if (i != 0 and index.entries[i - 1].first == key) continue; // only the first entry of a key is indexed
+            index.insert(key, i);
+        }
+        return index;
+    }
+
+    template<typename Container>
+    static HashIndex Bulkload(const Container &C) {
+        using std::begin, std::end;
+        return Bulkload(begin(C), end(C));
+    }
+
+    HashIndex() : mask(0) { }
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex(HashIndex&&) = default;
+
+    /** Returns the number of entries. */
+    size_type size() const { return entries.size(); }
+    /** Returns the number of slots in the hash table. */
+    size_type capacity() const { return slots.size(); }
+
+    /** Returns an iterator to the first entry. */
+    iterator begin() { return entries.data(); }
+    /** Returns an iterator to the entry following the last entry. */
+    iterator end() { return entries.data() + entries.size(); }
+    /** Returns an iterator to the first entry. */
+    const_iterator begin() const { return entries.data(); }
+    /** Returns an iterator to the entry following the last entry. */
+    const_iterator end() const { return entries.data() + entries.size(); }
+    /** Returns an iterator to the first entry. */
+    const_iterator cbegin() const { return entries.data(); }
+    /** Returns an iterator to the entry following the last entry. */
+    const_iterator cend() const { return entries.data() + entries.size(); }
+
+    /** Returns an iterator to the first entry with a key that equals `key`, or `end()` if no such entry exists. */
+    const_iterator find(const key_type key) const { return cbegin() + lookup(key); }
+    /** Returns an iterator to the first entry with a key that equals `key`, or `end()` if no such entry exists. */
+    iterator find(const key_type key) { return begin() + lookup(key); }
+};
@@ -0,0 +1,222 @@
+/*
+Implementation of multi-version concurrency control for the row store
+*/
+
+#include "MVCC.hpp"
+#include <algorithm>
+
+
+MVCC::MVCC(RowStore &store)
+    : store(store)
+    , layouts(store.layouts())
+    , heads(BlockArena::DEFAULT_BLOCK_SIZE, BlockArena::DEFAULT_RESERVATION)
+    , redo(store.hand_over_log())
+    , num_rows_(store.num_rows())
+    , clock(0)
+{
+    const m::Table &table = static_cast<const m::Store&>(store).table();
+    for(auto &attr : table) {
+        sizes.push_back(attr.type->size());
+    }
+    row_size = layouts.back().block_stride;
+
+    //rows that exist already were written before every transaction
+    heads.reserve(std::max<std::size_t>(num_rows_, 1) * sizeof(UndoEntry*));
+}
+
+void MVCC::read_value(const char *row, std::size_t attr, std::vector<char> &value, bool &is_null) const
+{
+    const uint64_t offset = layouts[attr].offset;
+    value.assign((sizes[attr] + 7) / 8, 0);
+    if(sizes[attr] % 8) {
+        value[0] = (row[offset / 8] >> (offset % 8)) & 1;
+    } else {
+        std::memcpy(value.data(), row + offset / 8, sizes[attr] / 8);
+    }
+    const uint64_t bit = layouts.back().offset + attr;
+    is_null = not ((row[bit / 8] >> (bit % 8)) & 1);
+}
+
+void MVCC::write_value(char *row, std::size_t attr, const char *value, bool is_null) const
+{
+    auto set_bit = [row](uint64_t bit, bool set) {
+        row[bit / 8] = (row[bit / 8] & ~(1 << (bit % 8))) | (uint8_t(set) << (bit % 8));
+    };
+    //booleans are single bits, all other values occupy whole bytes
+    if(sizes[attr] % 8) {
+        set_bit(layouts[attr].offset, value[0] & 1);
+    } else {
+        std::memcpy(row + layouts[attr].offset / 8, value, sizes[attr] / 8);
+    }
+    set_bit(layouts.back().offset + attr, not is_null);
+}
+
+MVCC::Transaction & MVCC::begin()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    active.emplace_back();
+    auto &txn = active.back();
+    txn.self = std::prev(active.end());
+    txn.start = clock.load();
+    txn.id = next_id++;
+    txn.sequence = next_sequence++;
+    txn.num_rows_ = num_rows_.load();
+    return txn;
+}
+
+void MVCC::commit(Transaction &txn)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t lsn = 0;
+    if(txn.undo.empty()) {
+        active.erase(txn.self);
+    } else {
+        //log the rows in commit order; no other transaction changes them before their deltas are committed
+        if(redo) {
+            std::vector<std::size_t> rows;
+            for(auto &e : txn.undo) rows.push_back(e.row);
+            std::sort(rows.begin(), rows.end());
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+            lsn = redo->log_update(layouts, rows);
+        }
+        //transactions that begin after the clock advanced see all deltas with their commit timestamp
+        const uint64_t timestamp = clock.load() + 1;
+        for(auto &e : txn.undo) {
+            e.timestamp.store(timestamp, std::memory_order_release);
+        }
+        clock.store(timestamp, std::memory_order_release);
+        txn.commit_timestamp = timestamp;
+        committed.splice(committed.end(), active, txn.self);
+    }
+    collect();
+    //concurrent commits wait for the same sync of the log
+    lock.unlock();
+    if(lsn) redo->wait_durable(lsn);
+}
+
+void MVCC::abort(Transaction &txn)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    //restore the rows before removing the deltas, so that readers undo the changes until then
+    for(auto it = txn.undo.rbegin(); it != txn.undo.rend(); ++it) {
+        if(it->attr == INSERTED) {
+            it->timestamp.store(ABORTED);
+            continue;
+        }
+        std::lock_guard<std::mutex> writing(in_place);
+        store.before_update(it->row);
+        write_value(row_address(it->row), it->attr, it->before.data(), it->was_null);
+        store.after_update(it->row, it->attr);
+        head_of(it->row).store(it->next.load());
+    }
+    if(txn.inserted) {
+        aborted.splice(aborted.end(), active, txn.self);
+    } else {
+        txn.unlinked = next_sequence;
+        unlinked.splice(unlinked.end(), active, txn.self);
+    }
+    collect();
+}
+
+RowRange MVCC::insert(Transaction &txn)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(redo) redo->skip_rows(store.num_rows()); //the row is logged when `txn` commits
+    std::unique_lock<std::mutex> writing(in_place); //appending seals the block of the previous row
+    RowRange range = store.append(1);
+    writing.unlock();
+    heads.reserve((range.first + 1) * sizeof(UndoEntry*));
+    txn.undo.emplace_back(txn.id, range.first, INSERTED);
+    txn.inserted = true;
+    head_of(range.first).store(&txn.undo.back());
+    num_rows_.store(range.first + 1);
+    return range;
+}
+
+bool MVCC::update(Transaction &txn, std::size_t row, std::size_t attr, const char *value, bool is_null)
+{
+    if(row >= num_rows_.load() || attr >= sizes.size()) {
+        std::cout << "Error in MVCC::update: row " << row << " or attribute " << attr << " does not exist" << "\n";
+        exit(1);
+    }
+    auto &head = head_of(row);
+    char *current = row_address(row);
+    auto &e = txn.undo.emplace_back(txn.id, row, attr);
+    UndoEntry *first = head.load();
+    do {
+        //first updater wins: the newest version must be visible to `txn`
+        if(first) {
+            const uint64_t timestamp = first->timestamp.load();
+            if(timestamp != txn.id && timestamp > txn.start) {
+                txn.undo.pop_back();
+                return false;
+            }
+        }
+        e.next.store(first);
+        read_value(current, attr, e.before, e.was_null);
+    } while(not head.compare_exchange_weak(first, &e));
+
+    //the delta is in the chain before the row changes, readers that copy the row meanwhile undo the change
+    std::lock_guard<std::mutex> writing(in_place);
+    store.before_update(row);
+    write_value(current, attr, value, is_null);
+    store.after_update(row, attr);
+    return true;
+}
+
+bool MVCC::read(const Transaction &txn, std::size_t row, char *image) const
+{
+    auto &head = head_of(row);
+    const char *current = row_address(row);
+    UndoEntry *first;
+    //copy the row until no delta was added or removed meanwhile, changes to the copy are undone by the deltas
+    do {
+        first = head.load(std::memory_order_acquire);
+        std::memcpy(image, current, row_size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(head.load(std::memory_order_relaxed) != first);
+
+    for(UndoEntry *e = first; e; e = e->next.load(std::memory_order_acquire)) {
+        const uint64_t timestamp = e->timestamp.load(std::memory_order_acquire);
+        if(timestamp == txn.id || timestamp <= txn.start) break; //this and all older versions are visible
+        if(e->attr == INSERTED) return false;
+        write_value(image, e->attr, e->before.data(), e->was_null);
+    }
+    return true;
+}
+
+void MVCC::unlink(UndoEntry &e)
+{
+    auto &head = head_of(e.row);
+    UndoEntry *first = &e;
+    if(head.compare_exchange_strong(first, nullptr)) return;
+    //newer deltas were added, cut the chain after the last of them
+    for(UndoEntry *p = first; p; p = p->next.load()) {
+        if(p->next.load() == &e) {
+            p->next.store(nullptr);
+            return;
+        }
+    }
+}
+
+void MVCC::collect()
+{
+    uint64_t oldest_start = clock.load(), oldest_sequence = next_sequence;
+    for(auto &txn : active) {
+        oldest_start = std::min(oldest_start, txn.start);
+        oldest_sequence = std::min(oldest_sequence, txn.sequence);
+    }
+    //no active transaction undoes deltas committed before it began, unlink them from the version chains
+    while(not committed.empty() && committed.front().commit_timestamp <= oldest_start) {
+        auto &txn = committed.front();
+        for(auto &e : txn.undo) {
+            unlink(e);
+        }
+        txn.unlinked = next_sequence;
+        unlinked.splice(unlinked.end(), committed, committed.begin());
+    }
+    //free deltas that were unlinked before the oldest active transaction began
+    while(not unlinked.empty() && unlinked.front().unlinked <= oldest_sequence) {
+        unlinked.pop_front();
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "BlockArena.hpp"
+#include "RowRange.hpp"
+#include "RowStore.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <vector>
+
+
+/*
+ * Multi-version concurrency control for a `RowStore`.
+ * Rows are updated in place.  The values an update replaces are kept as undo deltas in a side buffer of the updating
+ * transaction, and the deltas of a row form its version chain, newest first.  A delta carries the id of its
+ * transaction until the transaction commits and its commit timestamp afterwards.  A transaction sees the rows as they
+ * were when it began: reading a row copies its newest version and undoes every delta the transaction must not see.
+ * Readers never lock.  A transaction that updates a row changed by a transaction it does not see must abort.
+ * Deltas are reclaimed once no transaction can need them anymore.
+ * Writing a row in place widens the zones of its block in the zone maps of the store, and copies its segment for the
+ * snapshots of the store that see it first, so both stay valid for the newest versions of the rows.  Zone maps must
+ * not be read while transactions write.
+ * If the store is attached to a log, the layer logs the rows a transaction inserted and updated when it commits,
+ * instead of the store logging appended rows.  The log must be attached before the layer is created.
+ * While the layer exists, rows must only be inserted and updated through it, and no row is dropped.
+ * Refer Neumann, Mühlbauer, and Kemper, "Fast Serializable Multi-Version Concurrency Control for Main-Memory Database
+ * Systems", SIGMOD 2015
+ */
+struct MVCC
+{
+    /** Transaction ids are larger than every commit timestamp. */
+    static constexpr uint64_t UNCOMMITTED = uint64_t(1) << 63;
+
+    private:
+    /** Timestamp of the insertion of a row by an aborted transaction, which no transaction sees. */
+    static constexpr uint64_t ABORTED = ~uint64_t(0);
+    /** Attribute of a delta that undoes the insertion of its row. */
+    static constexpr std::size_t INSERTED = ~std::size_t(0);
+
+    struct UndoEntry
+    {
+        std::atomic<uint64_t> timestamp; //id of the transaction until it commits, its commit timestamp afterwards
+        std::atomic<UndoEntry*> next; //the next older delta of the row
+        std::size_t row;
+        std::size_t attr; //the updated attribute, or `INSERTED`
+        bool was_null;
+        std::vector<char> before; //value of the attribute before the update
+
+        UndoEntry(uint64_t id, std::size_t row, std::size_t attr)
+            : timestamp(id), next(nullptr), row(row), attr(attr), was_null(false)
+        { }
+    };
+
+    public:
+    struct Transaction
+    {
+        friend struct MVCC;
+
+        private:
+        uint64_t start; //commit timestamp of the last transaction committed before this one began
+        uint64_t id;
+        uint64_t sequence; //order in which transactions began
+        uint64_t commit_timestamp = 0;
+        uint64_t unlinked = 0; //`sequence` of the next transaction to begin after the deltas were unlinked
+        std::size_t num_rows_; //rows that existed when the transaction began
+        bool inserted = false;
+        std::deque<UndoEntry> undo; //side buffer of the deltas of the transaction, never moved
+        std::list<Transaction>::iterator self;
+
+        public:
+        /** Returns the number of rows that existed when the transaction began.  Rows it inserted itself follow. */
+        std::size_t num_rows() const { return num_rows_; }
+        /** Returns the number of deltas written by the transaction. */
+        std::size_t num_versions() const { return undo.size(); }
+    };
+
+    private:
+    RowStore &store;
+    std::vector<AttributeLayout> layouts; //of the rows in the store, the last one for the null bitmaps
+    std::vector<std::size_t> sizes; //bits of every attribute
+    std::size_t row_size; //bytes of a row
+    BlockArena heads; //newest delta of every row, never moved
+    StoreLog *redo; //the log of the store, nullptr if it has none
+    std::atomic<std::size_t> num_rows_; //rows visible to transactions that begin now
+    std::atomic<uint64_t> clock; //commit timestamp of the last committed transaction
+    std::mutex mutex; //serializes beginning, committing, and aborting transactions, and inserting rows
+    std::mutex in_place; //serializes writing rows in place with each other and with sealing their blocks
+    uint64_t next_id = UNCOMMITTED, next_sequence = 0;
+    std::list<Transaction> active;
+    std::list<Transaction> committed; //in commit order, their deltas may still be undone by active transactions
+    std::list<Transaction> unlinked; //their deltas are unreachable, but may still be read by active transactions
+    std::list<Transaction> aborted; //their inserted rows are never visible
+
+    std::atomic<UndoEntry*> & head_of(std::size_t row) const {
+        return reinterpret_cast<std::atomic<UndoEntry*>*>(heads.data())[row];
+    }
+    char * row_address(std::size_t row) const { return layouts.back().base + row * row_size; }
+    void read_value(const char *row, std::size_t attr, std::vector<char> &value, bool &is_null) const;
+    void write_value(char *row, std::size_t attr, const char *value, bool is_null) const;
+    bool update(Transaction &txn, std::size_t row, std::size_t attr, const char *value, bool is_null);
+    void unlink(UndoEntry &e);
+    void collect();
+
+    public:
+    explicit MVCC(RowStore &store);
+
+    /** Begins a transaction that sees the rows as they are now. */
+    Transaction & begin();
+    /** Commits `txn`, making its changes visible to transactions that begin afterwards, and waits until they are
+     * durable if the store has a log.  `txn` ends and must not be used anymore. */
+    void commit(Transaction &txn);
+    /** Aborts `txn` and undoes its changes.  Rows it inserted stay in the store but are never visible.  `txn` ends
+     * and must not be used anymore. */
+    void abort(Transaction &txn);
+
+    /** Appends a row that becomes visible to other transactions once `txn` commits, and returns it for writing. */
+    RowRange insert(Transaction &txn);
+    /** Sets attribute `attr` of `row` to `value`.  Returns false if `row` was changed by a transaction that `txn` does
+     * not see; `txn` must abort then. */
+    template<typename T>
+    bool update(Transaction &txn, std::size_t row, std::size_t attr, const T &value) {
+        if (sizeof(T) * 8 != sizes.at(attr)) {
+            std::cout << "Error in MVCC::update: value of " << sizeof(T) << " bytes for an attribute of "
+                      << sizes[attr] << " bits" << "\n";
+            exit(1);
+        }
+        return update(txn, row, attr, reinterpret_cast<const char*>(&value), false);
+    }
+    /** Sets the boolean attribute `attr` of `row` to `value`. */
+    bool update(Transaction &txn, std::size_t row, std::size_t attr, bool value) {
+        const char byte = value;
+        return update(txn, row, attr, &byte, false);
+    }
+    /** Sets the character sequence attribute `attr` of `row` to `str`, padded with NUL characters. */
+    bool update(Transaction &txn, std::size_t row, std::size_t attr, const char *str) {
+        std::vector<char> value(sizes.at(attr) / 8);
+        std::strncpy(value.data(), str, value.size());
+        return update(txn, row, attr, value.data(), false);
+    }
+    /** Sets attribute `attr` of `row` to NULL. */
+    bool set_null(Transaction &txn, std::size_t row, std::size_t attr) {
+        const std::vector<char> value((sizes.at(attr) + 7) / 8);
+        return update(txn, row, attr, value.data(), true);
+    }
+
+    /** Returns the number of bytes of a row. */
+    std::size_t row_bytes() const { return row_size; }
+    /** Copies the version of `row` that `txn` sees to the `row_bytes()` bytes at `image`.  Returns false if `txn`
+     * does not see the row at all. */
+    bool read(const Transaction &txn, std::size_t row, char *image) const;
+    /** Calls `callback(row, image)` for every row that `txn` sees, with the version it sees. */
+    template<typename F>
+    void scan(const Transaction &txn, F &&callback) const {
+        std::vector<char> image(row_size);
+        const std::size_t n = std::max(txn.num_rows_, txn.inserted ? num_rows_.load() : 0);
+        for (std::size_t row = 0; row != n; ++row) {
+            if (read(txn, row, image.data())) callback(row, static_cast<const char*>(image.data()));
+        }
+    }
+
+    /** Returns the value of attribute `attr` in the row `image`. */
+    template<typename T>
+    T get(const char *image, std::size_t attr) const {
+        T value;
+        std::memcpy(&value, image + layouts[attr].offset / 8, sizeof(T));
+        return value;
+    }
+    /** Returns the value of the boolean attribute `attr` in the row `image`. */
+    bool get_bit(const char *image, std::size_t attr) const {
+        const uint64_t bit = layouts[attr].offset;
+        return (image[bit / 8] >> (bit % 8)) & 1;
+    }
+    /** Returns true iff attribute `attr` is NULL in the row `image`. */
+    bool is_null(const char *image, std::size_t attr) const {
+        const uint64_t bit = layouts.back().offset + attr;
+        return not ((image[bit / 8] >> (bit % 8)) & 1); //a set bit marks a present value
+    }
+
+    /** Returns the number of transactions whose deltas are kept. */
+    std::size_t num_retained() const { return committed.size() + unlinked.size(); }
+};
@@ -0,0 +1,113 @@
+/*
+Implementation of PAX store
+*/
+
+#include "PaxStore.hpp"
+
+
+//compute the offsets of all minipages of a page holding `rowsPerPage` rows and return the bytes used by the page
+std::size_t PaxStore::computeLayout(const m::Table &table, std::size_t rowsPerPage, std::vector<uint64_t> &offsets)
+{
+    offsets.clear();
+    std::size_t offset = 0; //in bytes
+    for(auto &attr : table) {
+        std::size_t size = attr.type->size(); //attribute size in bits
+        //align the minipage to the size of the attribute, character sequences and booleans to bytes
+        std::size_t align = (size > 8 && !attr.type->is_character_sequence()) ? size / 8 : 1;
+        offset = (offset + align - 1) / align * align;
+        offsets.push_back(offset * 8);
+        offset += (rowsPerPage * size + 7) / 8;
+    }
+    //minipage for the null bitmaps
+    offsets.push_back(offset * 8);
+    offset += (rowsPerPage * table.size() + 7) / 8;
+    return offset;
+}
+
+void PaxStore::createLinearization()
+{
+    //every page holds a finite sequence of rows, one minipage per attribute
+    auto lin = std::make_unique<m::Linearization>(m::Linearization::CreateInfinite(1));
+    auto page = std::make_unique<m::Linearization>(m::Linearization::CreateFinite(table().size() + 1, rowsPerPage));
+    std::size_t i = 0;
+    for(auto &attr : table()) {
+        page->add_sequence(minipageOffsets[i++], attr.type->size(), attr);
+    }
+    page->add_null_bitmap(minipageOffsets[i], table().size());
+    lin->add_sequence(uint64_t(reinterpret_cast<uintptr_t>(pages.data())), pageSize, std::move(page));
+    linearization(std::move(lin));
+}
+
+PaxStore::PaxStore(const m::Table &table, AllocationPolicy policy)
+    : Store(table)
+    , rows(0)
+    , pageSize(PAGE_SIZE)
+    , pages(BlockArena::DEFAULT_BLOCK_SIZE, BlockArena::DEFAULT_RESERVATION, policy)
+{
+    /*Find the page size and the number of rows per page. */
+    std::size_t rowBits = table.size(); //null bitmap
+    for(auto &attr : table) {
+        rowBits += attr.type->size();
+    }
+    //double the page size until at least one row fits
+    while(computeLayout(table, 1, minipageOffsets) > pageSize) {
+        pageSize *= 2;
+    }
+    //start from the unpadded estimate and remove rows until the padded minipages fit
+    rowsPerPage = pageSize * 8 / rowBits;
+    while(computeLayout(table, rowsPerPage, minipageOffsets) > pageSize) {
+        rowsPerPage--;
+    }
+
+    /*Allocate the first page. */
+    pages.reserve(pageSize);
+    capacity = pages.size() / pageSize * rowsPerPage;
+
+    /*Create linearization. */
+    createLinearization();
+}
+
+PaxStore::~PaxStore()
+{
+    /*Allocated pages are freed by the arena. */
+    rows = 0;
+    capacity = 0;
+}
+
+std::size_t PaxStore::num_rows() const
+{
+    return rows;
+}
+
+void PaxStore::append()
+{
+    //commit the next page if all pages are full
+    if(rows == capacity) {
+        pages.reserve(pages.size() + pageSize);
+        capacity = pages.size() / pageSize * rowsPerPage;
+    }
+    rows++;
+}
+
+void PaxStore::drop()
+{
+    if(rows > 0) rows--;
+    //return unused pages to the OS once the table shrank enough
+    std::size_t pagesInUse = (rows + rowsPerPage - 1) / rowsPerPage;
+    if(pages.trim(pagesInUse * pageSize)) {
+        capacity = pages.size() / pageSize * rowsPerPage;
+    }
+}
+
+void PaxStore::dump(std::ostream &out) const
+{
+    /*Print description of this store to `out`. */
+    out << "PaxStore with pages of " << pageSize << " bytes holding " << rowsPerPage << " rows" << "\n";
+    std::size_t i = 0;
+    for(auto &attr : table()) {
+        out << "Minipage of " << attr.name << " at bit offset " << minipageOffsets[i++] << "\n";
+    }
+    out << "Minipage of null bitmap at bit offset " << minipageOffsets[i] << "\n";
+    out << rows << " rows in use and " << capacity << " rows are allocated." << std::endl;
+    out.flush();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "BlockArena.hpp"
+#include <mutable/mutable.hpp>
+
+
+/*
+ * Partition Attributes Across (PAX) layout.
+ * Rows are grouped into fixed-size pages.  Inside a page, the values of each attribute are stored contiguously in a
+ * minipage, followed by a minipage for the null bitmaps of the rows in the page.
+ * Refer Ailamaki et al., "Weaving Relations for Cache Performance", VLDB 2001
+ */
+struct PaxStore : m::Store
+{
+    /** Default size of a page in bytes.  Pages grow beyond that if a single row does not fit. */
+    static constexpr std::size_t PAGE_SIZE = 4096;
+
+    private:
+    /*Declare necessary fields. */
+    std::size_t rows, capacity; //#rows in use, #rows fitting into the committed pages
+    std::size_t pageSize; //size of a page in bytes
+    std::size_t rowsPerPage; //number of rows in a page
+    std::vector<uint64_t> minipageOffsets; //offsets of the minipages inside a page in bits, last one for null bitmap
+    BlockArena pages; //committed page by page, never moved
+
+    static std::size_t computeLayout(const m::Table &table, std::size_t rowsPerPage, std::vector<uint64_t> &offsets);
+    void createLinearization();
+
+    public:
+    PaxStore(const m::Table &table, AllocationPolicy policy = AllocationPolicy());
+    ~PaxStore();
+
+    std::size_t num_rows() const override;
+    void append() override;
+    void drop() override;
+
+    void accept(m::StoreVisitor &v) override { v(*this); }
+    void accept(m::ConstStoreVisitor &v) const override { v(*this); }
+
+    void dump(std::ostream &out) const override;
+    using Store::dump;
+};
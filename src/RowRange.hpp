@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+/*
+ * Location of the values of one attribute, or of the null bitmaps, in the memory of a store.
+ * Rows are grouped into blocks of `rows_per_block` rows that are `block_stride` bytes apart.  Inside a block, the value
+ * of the first row starts `offset` bits after the beginning of the block, and consecutive values are `stride` bits
+ * apart.  A row store has blocks of a single row, a column store has blocks of a single value.
+ */
+struct AttributeLayout
+{
+    char *base;
+    std::size_t rows_per_block;
+    std::size_t block_stride; //in bytes
+    uint64_t offset; //in bits
+    uint64_t stride; //in bits
+
+    /** Returns the bit address of the value of `row`, relative to `base`. */
+    uint64_t bit_address(std::size_t row) const {
+        return (row / rows_per_block) * block_stride * 8 + offset + (row % rows_per_block) * stride;
+    }
+    /** Returns the address of the byte holding the first bit of the value of `row`. */
+    char * address(std::size_t row) const { return base + bit_address(row) / 8; }
+    /** Returns the position of the first bit of the value of `row` inside the byte at `address(row)`. */
+    unsigned bit(std::size_t row) const { return bit_address(row) % 8; }
+};
+
+/*
+ * A range of rows appended at once with `append(n)`.  The rows are writable until the next call that changes the
+ * number of rows of the store.  Rows are addressed relative to the beginning of the range.
+ */
+struct RowRange
+{
+    std::size_t first; //index of the first row of the range in the store
+    std::size_t num_rows;
+    std::vector<AttributeLayout> layouts; //one per attribute, the last one for the null bitmaps
+
+    /** Writes `value` as the value of attribute `attr` of row `i`. */
+    template<typename T>
+    void set(std::size_t attr, std::size_t i, const T &value) {
+        std::memcpy(layouts[attr].address(first + i), &value, sizeof(T));
+    }
+
+    /** Writes the boolean `value` as the value of attribute `attr` of row `i`. */
+    void set(std::size_t attr, std::size_t i, bool value) { set_bit(layouts[attr], first + i, 0, value); }
+
+    /** Writes `length` characters of `str` to the character sequence attribute `attr` of row `i`, which holds `size`
+     * characters.  Shorter strings are padded with NUL characters. */
+    void set(std::size_t attr, std::size_t i, const char *str, std::size_t length, std::size_t size) {
+        char *p = layouts[attr].address(first + i);
+        if(length > size) length = size;
+        std::memcpy(p, str, length);
+        std::memset(p + length, 0, size - length);
+    }
+
+    /** Marks attribute `attr` of row `i` as NULL or not NULL. */
+    void set_null(std::size_t attr, std::size_t i, bool is_null) {
+        set_bit(layouts.back(), first + i, attr, not is_null); //a set bit marks a present value
+    }
+
+    private:
+    static void set_bit(const AttributeLayout &layout, std::size_t row, std::size_t n, bool value) {
+        const uint64_t bit = layout.bit(row) + n;
+        char &byte = layout.address(row)[bit / 8];
+        if (layout.rows_per_block > 1) {
+            // the byte is shared with other rows, which may be written by other threads
+            if (value) __atomic_fetch_or(&byte, char(1 << (bit % 8)), __ATOMIC_RELAXED);
+            else __atomic_fetch_and(&byte, char(~(1 << (bit % 8))), __ATOMIC_RELAXED);
+            return;
+        }
+        byte = (byte & ~(1 << (bit % 8))) | (uint8_t(value) << (bit % 8));
+    }
+};
@@ -3,6 +3,8 @@ To debug the code, uncomment the cout statements.
 Optionally, add a dump() statement for the respective objects */
 
 #include "RowStore.hpp"
+#include <algorithm>
+#include <numeric>
 
 //function to find paddding and resulting offset for a data type
 //Refer https://en.wikipedia.org/wiki/Data_structure_alignment
@@ -14,34 +16,42 @@ uint32_t RowStore::find_aligned(uint32_t offset_in_bits, uint32_t align_in_bits)
     return aligned * 8; //return offset in bits
 }
 
+//alignment of an attribute in bits; booleans are packed bitwise, character sequences are aligned to bytes
+uint32_t RowStore::alignment_of(const m::Attribute &attr) {
+    uint32_t size = attr.type->size();
+    if(size <= 1) return 1;
+    if(attr.type->is_character_sequence()) return 8;
+    return size;
+}
+
 //function to get address offsets for table attributes
 // use these to calculate size of a row
+//attributes are placed by decreasing alignment, so that no padding is needed between them, and booleans are packed
+//into consecutive bits next to the null bitmap; offsets are still stored in the order of the table
 void RowStore::getRowStoreSizes(const m::Table &table, std::vector<uint32_t> &absoluteSizes, std::size_t &rowSize){
-    uint32_t absoluteSize = 0, maxSize, size, sizeAligned;
-    maxSize = 1; //size of largest attribute for alignment
-    for(auto &attr: table) {
-        size = attr.type->size(); //attribute size in bits
-        sizeAligned = 0;
-        //following condition ignores booleans
-        if(size > 8) {
-            //padding related calculations
-            if(attr.type->is_character_sequence()) {
-                sizeAligned = 8; //since a char is 1 byte, retain size of this type to 8 bits
+    std::vector<std::size_t> order(table.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&table](std::size_t left, std::size_t right) {
+        return alignment_of(table[left]) > alignment_of(table[right]);
+    });
+
+    uint32_t absoluteSize = 0, maxSize, align;
+    maxSize = 1; //alignment of largest attribute for the row size
+    absoluteSizes.assign(table.size() + 1, 0);
+    for(auto i: order) {
+        auto &attr = table[i];
+        align = alignment_of(attr);
+        if(align >= 8) {
+            absoluteSize = find_aligned(absoluteSize, align);
+            if(maxSize < align) {
+                maxSize = align;
             }
-            else {
-                sizeAligned = size;
-            } 
-            absoluteSize = find_aligned(absoluteSize, sizeAligned);
-            if(maxSize < sizeAligned) {
-                maxSize = sizeAligned;
-            }    
         }
-        //std::cout << "Offset for attribute " << attr.name <<"(" << size <<") is at " << absoluteSize << "\n";
-        absoluteSizes.push_back(absoluteSize);
-        absoluteSize += size;
+        absoluteSizes[i] = absoluteSize;
+        absoluteSize += attr.type->size();
     }
     //std::cout << "Offset for null bitmap at " << absoluteSize << "\n";
-    absoluteSizes.push_back(absoluteSize);
+    absoluteSizes[table.size()] = absoluteSize;
     absoluteSize += table.size(); //#attributes = bits for null bitmap
     rowSize = find_aligned(absoluteSize, maxSize)/8;
     //std::cout << "Size with padding = " << rowSize << "\n";
@@ -64,26 +74,72 @@ void RowStore::createLinearization(const m::Table &table, std::vector<uint32_t>
 }
 
 //row store constructor
-RowStore::RowStore(const m::Table &table)
-        : Store(table), row_table(table)
+RowStore::RowStore(const m::Table &table, AllocationPolicy policy)
+        : Store(table)
+        , row_blocks(BlockArena::DEFAULT_BLOCK_SIZE, BlockArena::DEFAULT_RESERVATION, policy)
+        , row_table(table)
+        , zoneMap(table)
 {   
     /*Allocate memory. */
     rowSize = 0;
-    currentCapacity = 10; //create memory for 10 row
     rowsInUse = 0;
     getRowStoreSizes(row_table, offsets, rowSize);
-    row_address = (char*)malloc(rowSize * currentCapacity); //allocate memory
+    row_blocks.reserve(rowSize); //commit the first block
+    row_address = row_blocks.data();
+    currentCapacity = row_blocks.size() / rowSize;
     //dump(std::cout);
 
     /*Create linearization. */
     createLinearization(row_table, offsets, row_address);
+    describeSnapshots();
+}
+
+//persistent row store constructor
+RowStore::RowStore(const m::Table &table, const char *filename)
+        : Store(table)
+        , row_blocks(filename, StoreFileHeader::SIZE)
+        , row_table(table)
+        , zoneMap(table)
+{
+    rowSize = 0;
+    getRowStoreSizes(row_table, offsets, rowSize);
+
+    /*Check that the file holds rows of the same layout. */
+    uint64_t layout = StoreFileHeader::Fingerprint(StoreFileHeader::EMPTY_LAYOUT, rowSize);
+    for(std::size_t i = 0; i != row_table.size(); ++i) {
+        layout = StoreFileHeader::Fingerprint(layout, row_table[i]);
+        layout = StoreFileHeader::Fingerprint(layout, offsets[i]);
+    }
+    fileHeader = &StoreFileHeader::Open(row_blocks.header_data(), StoreFileHeader::ROW_STORE, row_table.size(), layout,
+                                        filename);
+    rowsInUse = fileHeader->num_rows;
+
+    /*Map the rows of the file. */
+    row_blocks.reserve(std::max<std::size_t>(rowsInUse, 1) * rowSize);
+    row_address = row_blocks.data();
+    currentCapacity = row_blocks.size() / rowSize;
+
+    /*Create linearization. */
+    createLinearization(row_table, offsets, row_address);
+    describeSnapshots();
+}
+
+//snapshots copy segments of as many whole rows as fit into a block
+void RowStore::describeSnapshots()
+{
+    std::size_t segment_rows = std::max<std::size_t>(row_blocks.block_bytes() / rowSize, 1);
+    std::vector<std::pair<std::size_t, AttributeLayout>> attributes;
+    for(auto offset : offsets) {
+        attributes.emplace_back(0, AttributeLayout{ nullptr, 1, rowSize, offset, 0 });
+    }
+    snapshots.describe({ { row_address, segment_rows, segment_rows * rowSize } }, std::move(attributes));
+    snapshots.publish(rowsInUse);
 }
 
 //destructor for row store
 RowStore::~RowStore()
 {
-    /*Free allocated memory. */
-    free(row_address);
+    /*Allocated blocks are freed by the arena. */
     rowsInUse = 0;
     currentCapacity = 0;
     return;
@@ -95,24 +151,86 @@ std::size_t RowStore::num_rows() const
     return rowsInUse;
 }
 
+//append rows, sealing the blocks of rows that were completed before
+void RowStore::grow(std::size_t n)
+{
+    //every row before the new ones has been written, summarize the blocks that filled up
+    while((zoneMap.num_blocks() + 1) * zoneMap.block_rows() <= rowsInUse) {
+        zoneMap.seal([this](std::size_t attr, std::size_t row) { return locate(attr, row); });
+    }
+    snapshots.publish(rowsInUse);
+    //log the written rows in batches, so that a record carries many rows
+    if(redo && redo->num_unlogged(rowsInUse) >= StoreLog::BATCH_ROWS) {
+        redo->log_rows(layouts(), rowsInUse);
+    }
+    //check if enough memory to allocate additional rows
+    if(rowsInUse + n > currentCapacity) {
+        reserve(rowsInUse + n);
+    }
+    //rows dropped while pinned are only overwritten once no reader may read them in place
+    snapshots.before_write(rowsInUse, n);
+    rowsInUse += n;
+    if(fileHeader) fileHeader->num_rows = rowsInUse;
+}
+
+void RowStore::reserve(std::size_t num_rows)
+{
+    //commit the next blocks; existing rows stay in place, so the linearisation remains valid
+    row_blocks.reserve(num_rows * rowSize);
+    currentCapacity = row_blocks.size() / rowSize;
+}
+
 //append new row
 void RowStore::append()
 {
-    //check if enough memory to allocate additional row
-    if(rowsInUse == currentCapacity) {
-        currentCapacity *= 2;
-        row_address = (char*)realloc(row_address, rowSize * currentCapacity);
-        
-        if(row_address == NULL) {
-            //throw error
-            std::cout << "Error in reallocating memory" << "\n";
-            exit(1);
-        }
-        //reconstruct linearisation for new row address
-        createLinearization(row_table, offsets, row_address);
+    grow(1);
+}
+
+RowRange RowStore::append(std::size_t n)
+{
+    RowRange range{ rowsInUse, n, layouts() };
+    grow(n);
+    return range;
+}
+
+void RowStore::attach_log(WriteAheadLog &log, uint32_t id)
+{
+    if(versioned) {
+        std::cout << "Error in RowStore::attach_log: the log must be attached before a transaction layer is created"
+                  << "\n";
+        exit(1);
     }
-    rowsInUse++;
-    return;
+    std::vector<std::size_t> sizes;
+    for(auto &attr : row_table) {
+        sizes.push_back(attr.type->size());
+    }
+    StoreLog::Replay(log, id, sizes, rowsInUse,
+                     [this](std::size_t n) { return append(n); },
+                     [this](std::size_t n) { while(rowsInUse > n) drop(); },
+                     [this]() { return layouts(); });
+    redo = std::make_unique<StoreLog>(log, id, std::move(sizes), rowsInUse);
+}
+
+void RowStore::commit()
+{
+    if(redo && not versioned) redo->commit(layouts(), rowsInUse);
+}
+
+StoreLog * RowStore::hand_over_log()
+{
+    commit();
+    versioned = true;
+    return redo.get();
+}
+
+std::vector<AttributeLayout> RowStore::layouts() const
+{
+    //every block is a single row
+    std::vector<AttributeLayout> result;
+    for(auto offset : offsets) {
+        result.push_back(AttributeLayout{ row_address, 1, rowSize, offset, 0 });
+    }
+    return result;
 }
 
 void RowStore::drop()
@@ -120,6 +238,14 @@ void RowStore::drop()
     /* drop a row */
     if(rowsInUse > 0) {
         rowsInUse--;
+        if(fileHeader) fileHeader->num_rows = rowsInUse;
+        zoneMap.truncate(rowsInUse);
+        if(redo) redo->log_truncate(rowsInUse);
+        snapshots.preserve(rowsInUse);
+        //return unused blocks to the OS once the table shrank enough and no reader may read them
+        if(snapshots.quiescent() && row_blocks.trim(rowsInUse * rowSize)) {
+            currentCapacity = row_blocks.size() / rowSize;
+        }
     }
     else if(rowsInUse == 0){
         //just print that no rows exist, so cannot drop
@@ -137,6 +263,9 @@ void RowStore::dump(std::ostream &out) const
         out << attr.first <<", " << attr.second << "\n";
     }
     out << "Rows in use: " << rowsInUse << "\n";
+    out << "Row capacity: " << currentCapacity << " in " << row_blocks.num_blocks() << " blocks of "
+        << row_blocks.block_bytes() << " bytes" << "\n";
+    out << "Zone maps: " << zoneMap.num_blocks() << " blocks of " << zoneMap.block_rows() << " rows" << "\n";
     out.flush();
     return;
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
 
+#include "BlockArena.hpp"
+#include "RowRange.hpp"
+#include "Snapshot.hpp"
+#include "StoreFile.hpp"
+#include "WriteAheadLog.hpp"
+#include "ZoneMap.hpp"
 #include <mutable/mutable.hpp>
 #include <math.h> 
 
@@ -8,20 +14,78 @@ struct RowStore : m::Store
     private:
     /*Declare necessary fields. */
     std::size_t rowSize, rowsInUse; //size of 1 row, #rows in use
-    std::size_t currentCapacity; //current memory capacity
-    std::vector<uint32_t> offsets; //address offsets for linearisation
+    std::size_t currentCapacity; //number of rows that fit into the committed blocks
+    std::vector<uint32_t> offsets; //bit offsets for linearisation in table order, the last one for the null bitmap
     std::vector<std::pair<std::string, std::size_t>> attributes; //attributes of table
+    BlockArena row_blocks; //fixed-size blocks holding the rows, never moved
     char *row_address; //pointer to beginning of row
     const m::Table &row_table; 
+    ZoneMap zoneMap; //min/max and null count of every attribute per block of rows
+    StoreFileHeader *fileHeader = nullptr; //header of the file of a persistent store
+    SnapshotRegistry snapshots; //snapshots pinning rows, in segments of whole rows of a block
+    std::unique_ptr<StoreLog> redo; //redo logging of the rows, if the store is attached to a log
+    bool versioned = false; //true iff a transaction layer logs the rows it inserts and updates
 
     void createLinearization(const m::Table &table, std::vector<uint32_t> &absoluteSizes, char *row_address);
+    static uint32_t alignment_of(const m::Attribute &attr);
     uint32_t find_aligned(uint32_t offset_in_bits, uint32_t align_in_bits);
     void getRowStoreSizes(const m::Table &table, std::vector<uint32_t> &absoluteSizes, std::size_t &rowSize);
+    void grow(std::size_t n);
+    void describeSnapshots();
+    //address and bit offset of attribute `attr` of `row`, the index `offsets.size() - 1` refers to the null bitmap
+    std::pair<const char*, std::size_t> locate(std::size_t attr, std::size_t row) const {
+        return { row_address + row * rowSize + offsets[attr] / 8, offsets[attr] % 8 };
+    }
 
     public:
-    RowStore(const m::Table &table);
+    RowStore(const m::Table &table, AllocationPolicy policy = AllocationPolicy());
+    /** Creates a persistent store in the file `filename`, or reopens the rows stored there by a store of a table with
+     * the same layout.  Zone maps of reopened rows are built when the next row is appended. */
+    RowStore(const m::Table &table, const char *filename);
     ~RowStore();
 
+    /** Returns the zone maps of the sealed blocks of rows, used by scans to skip blocks. */
+    const ZoneMap & zone_map() const { return zoneMap; }
+
+    /** Returns the location of every attribute and of the null bitmaps. */
+    std::vector<AttributeLayout> layouts() const;
+    /** Commits memory for `num_rows` rows in total, so that appending up to that many rows never grows the store. */
+    void reserve(std::size_t num_rows);
+    /** Appends `n` rows at once and returns them for writing. */
+    RowRange append(std::size_t n);
+
+    /** Replays the rows logged for the store with id `id` in `log`, and logs all later appends and drops there.
+     * Rows the store holds already, e.g. a reopened persistent store, are not replayed. */
+    void attach_log(WriteAheadLog &log, uint32_t id = 0);
+    /** Waits until all rows appended so far are durable in the attached log.  Rows that are not committed are lost
+     * in a crash. */
+    void commit();
+    /** Hands the logging of rows over to a transaction layer, which logs the rows it inserts and updates once they
+     * are committed.  Waits until the rows appended so far are durable, and returns the log of the store, or nullptr
+     * if it is not attached to a log.  The store must not be attached to a log afterwards. */
+    StoreLog * hand_over_log();
+
+    /** Returns a consistent view of the rows written so far, which other threads may read while rows are appended
+     * and dropped.  Appending rows that no snapshot has seen never waits for readers. */
+    Snapshot snapshot() { return snapshots.pin(); }
+    /** Prepares overwriting attributes of `row` in place: snapshots that see the row copy it first.  Writers of
+     * different rows may call this concurrently, but must serialize their writes and `after_update()`. */
+    void before_update(std::size_t row) { snapshots.before_update(row); }
+    /** Widens the zone of attribute `attr` of the block of `row` to cover the value it was overwritten with. */
+    void after_update(std::size_t row, std::size_t attr) {
+        zoneMap.widen(attr, row, [this](std::size_t a, std::size_t r) { return locate(a, r); });
+    }
+    /** Makes all appended rows visible to new snapshots.  Otherwise rows become visible once the next row is
+     * appended, since they are written after `append()` returns. */
+    void publish() { snapshots.publish(rowsInUse); }
+
+    /** Returns the number of rows that fit into the committed blocks. */
+    std::size_t allocated_rows() const { return currentCapacity; }
+    /** Returns true iff the rows are kept in a file. */
+    bool is_persistent() const { return fileHeader != nullptr; }
+    /** Writes the rows of a persistent store back to its file and waits for completion. */
+    void sync() { row_blocks.sync(); }
+
     std::size_t num_rows() const override;
     void append() override;
     void drop() override;
@@ -0,0 +1,142 @@
+/*
+Implementation of snapshots of stores
+*/
+
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <thread>
+
+
+void Snapshot::release()
+{
+    if(registry && state_) registry->unpin(state_);
+    registry = nullptr;
+    state_.reset();
+}
+
+const char * Snapshot::address(std::size_t attr, std::size_t row) const
+{
+    auto &attribute = registry->attributes[attr];
+    auto &arena = registry->arenas[attribute.first];
+    const std::size_t segment = row / arena.segment_rows;
+    //a segment that was copied for this snapshot may have been overwritten in place since
+    const char *p = state_->copies[attribute.first][segment].load();
+    if(not p) p = arena.base + segment * arena.segment_bytes;
+    return p + attribute.second.bit_address(row % arena.segment_rows) / 8;
+}
+
+unsigned Snapshot::bit(std::size_t attr, std::size_t row) const
+{
+    auto &attribute = registry->attributes[attr];
+    return attribute.second.bit_address(row % registry->arenas[attribute.first].segment_rows) % 8;
+}
+
+bool Snapshot::is_null(std::size_t attr, std::size_t row) const
+{
+    return not get_bit(registry->attributes.size() - 1, row, attr); //a set bit marks a present value
+}
+
+Snapshot SnapshotRegistry::pin()
+{
+    auto s = std::make_shared<Snapshot::state>();
+    std::lock_guard<std::mutex> lock(mutex);
+    s->num_rows = published.load();
+    for(auto &a : arenas) {
+        const std::size_t num_segments = (s->num_rows + a.segment_rows - 1) / a.segment_rows;
+        s->copies.emplace_back(new std::atomic<const char*>[num_segments]);
+        for(std::size_t i = 0; i != num_segments; ++i) s->copies.back()[i].store(nullptr);
+    }
+    pinned.push_back(s);
+    num_pinned.store(pinned.size());
+    return Snapshot(this, std::move(s));
+}
+
+void SnapshotRegistry::unpin(const std::shared_ptr<Snapshot::state> &s)
+{
+    //the copies of the snapshot are freed with its state
+    std::lock_guard<std::mutex> lock(mutex);
+    pinned.erase(std::find(pinned.begin(), pinned.end(), s));
+    num_pinned.store(pinned.size());
+}
+
+//copy a segment of an arena for `s` unless it was copied before, called with `mutex` held
+bool SnapshotRegistry::copy(Snapshot::state &s, std::size_t arena, std::size_t segment)
+{
+    auto &a = arenas[arena];
+    auto &slot = s.copies[arena][segment];
+    if(slot.load()) return false;
+    const std::size_t first = segment * a.segment_rows;
+    const std::size_t rows = std::min(a.segment_rows, s.num_rows - first);
+    std::unique_ptr<char[]> copy(new char[a.segment_bytes]());
+    std::memcpy(copy.get(), a.base + segment * a.segment_bytes,
+                (rows * a.segment_bytes + a.segment_rows - 1) / a.segment_rows);
+    slot.store(copy.get());
+    s.owned.push_back(std::move(copy));
+    return true;
+}
+
+//check whether a reader began reading before epoch `e`, and may thus read segments copied since in place
+bool SnapshotRegistry::reading_before(uint64_t e)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto &s : pinned) {
+        const uint64_t r = s->reading.load();
+        if(r != 0 && r < e) return true;
+    }
+    return false;
+}
+
+void SnapshotRegistry::preserve(std::size_t num_rows)
+{
+    //lowering the published rows and pinning are serialized, so no new snapshot misses the copies
+    std::lock_guard<std::mutex> lock(mutex);
+    if(published.load() > num_rows) published.store(num_rows);
+    bool copied = false;
+    for(auto &s : pinned) {
+        if(s->num_rows <= num_rows) continue; //the snapshot does not see the dropped rows
+        for(std::size_t x = 0; x != arenas.size(); ++x) {
+            //a segment is copied when its first row seen by the snapshot is dropped, so no row after it was
+            //overwritten yet
+            copied |= copy(*s, x, num_rows / arenas[x].segment_rows);
+        }
+        preserved_begin = std::min(preserved_begin, num_rows);
+        preserved_end = std::max(preserved_end, s->num_rows);
+    }
+    //readers that began reading before the new epoch may still use the copied segments in place
+    if(copied) retired = epoch.fetch_add(1) + 1;
+}
+
+bool SnapshotRegistry::quiescent()
+{
+    if(preserved_begin >= preserved_end) return true;
+    if(not empty() && reading_before(retired)) return false;
+    preserved_begin = SIZE_MAX;
+    preserved_end = 0;
+    return true;
+}
+
+void SnapshotRegistry::before_write(std::size_t first_row, std::size_t n)
+{
+    if(first_row >= preserved_end || first_row + n <= preserved_begin) return;
+    while(not quiescent()) std::this_thread::yield();
+}
+
+void SnapshotRegistry::before_update(std::size_t row)
+{
+    if(empty()) return;
+    bool seen = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool copied = false;
+        for(auto &s : pinned) {
+            if(s->num_rows <= row) continue; //the snapshot does not see the row
+            seen = true;
+            for(std::size_t x = 0; x != arenas.size(); ++x) {
+                copied |= copy(*s, x, row / arenas[x].segment_rows);
+            }
+        }
+        if(copied) updated.store(epoch.fetch_add(1) + 1);
+    }
+    //the segment may have been copied by an earlier update, whose readers must be done as well
+    while(seen && reading_before(updated.load())) std::this_thread::yield();
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "RowRange.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+struct SnapshotRegistry;
+
+/*
+ * A consistent, read-only view of the first `num_rows()` rows of a store, taken while other threads keep appending to
+ * and dropping from it.
+ * The data of a store is split into segments of consecutive rows.  A snapshot reads segments in place until the
+ * store is about to overwrite or release rows the snapshot sees; the store then copies these segments for the
+ * snapshot first.  Values must be read inside `read()`, which marks the reader as active, so that the store does not
+ * reuse memory a reader may still be looking at.
+ * A snapshot is used by one thread at a time and must be released before its store is destroyed.
+ */
+struct Snapshot
+{
+    friend struct SnapshotRegistry;
+
+    private:
+    struct state
+    {
+        std::size_t num_rows;
+        std::vector<std::unique_ptr<std::atomic<const char*>[]>> copies; //per arena and segment, nullptr if in place
+        std::vector<std::unique_ptr<char[]>> owned; //memory of the copies
+        std::atomic<uint64_t> reading{0}; //epoch at which the current `read()` began, 0 outside of `read()`
+    };
+
+    SnapshotRegistry *registry = nullptr;
+    std::shared_ptr<state> state_;
+
+    public:
+    Snapshot() = default;
+    Snapshot(SnapshotRegistry *registry, std::shared_ptr<state> s) : registry(registry), state_(std::move(s)) { }
+    ~Snapshot() { release(); }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot(Snapshot &&other) : registry(std::exchange(other.registry, nullptr)), state_(std::move(other.state_)) { }
+    Snapshot & operator=(Snapshot &&other) {
+        release();
+        registry = std::exchange(other.registry, nullptr);
+        state_ = std::move(other.state_);
+        return *this;
+    }
+
+    /** Unpins the rows of the snapshot.  The snapshot is empty afterwards. */
+    void release();
+
+    /** Returns the number of rows visible to the snapshot. */
+    std::size_t num_rows() const { return state_ ? state_->num_rows : 0; }
+
+    /** Calls `f()`, which may read values of the snapshot. */
+    template<typename F>
+    void read(F &&f) const;
+
+    /** Returns the address of the byte holding the first bit of attribute `attr` of `row`.  The index
+     * `table.size()` refers to the null bitmap.  Must be called inside `read()`. */
+    const char * address(std::size_t attr, std::size_t row) const;
+    /** Returns the position of the first bit of attribute `attr` of `row` inside the byte at `address()`. */
+    unsigned bit(std::size_t attr, std::size_t row) const;
+
+    /** Returns the value of attribute `attr` of `row`.  Must be called inside `read()`. */
+    template<typename T>
+    T get(std::size_t attr, std::size_t row) const {
+        T value;
+        std::memcpy(&value, address(attr, row), sizeof(T));
+        return value;
+    }
+    /** Returns the value of the boolean attribute `attr` of `row`.  Must be called inside `read()`. */
+    bool get_bit(std::size_t attr, std::size_t row, std::size_t n = 0) const {
+        const unsigned b = bit(attr, row) + n;
+        //the byte may be shared with rows that are written concurrently
+        return (__atomic_load_n(address(attr, row) + b / 8, __ATOMIC_RELAXED) >> (b % 8)) & 1;
+    }
+    /** Returns true iff attribute `attr` of `row` is NULL.  Must be called inside `read()`. */
+    bool is_null(std::size_t attr, std::size_t row) const;
+};
+
+/*
+ * The snapshots of a store.
+ * The store describes its memory as arenas that are split into segments of `segment_rows` rows, and every attribute
+ * by the arena holding it and its layout inside a segment.  The store publishes the number of rows that are fully
+ * written, calls `preserve()` before it drops rows and `before_write()` before it overwrites rows, and only releases
+ * memory if `quiescent()`.  Rows that are updated in place are protected by `before_update()`.
+ */
+struct SnapshotRegistry
+{
+    struct arena
+    {
+        const char *base;
+        std::size_t segment_rows;
+        std::size_t segment_bytes;
+    };
+
+    private:
+    friend struct Snapshot;
+
+    std::vector<arena> arenas;
+    std::vector<std::pair<std::size_t, AttributeLayout>> attributes; //arena and layout relative to a segment
+    std::mutex mutex; //protects `pinned`
+    std::vector<std::shared_ptr<Snapshot::state>> pinned;
+    std::atomic<std::size_t> num_pinned{0};
+    std::atomic<std::size_t> published{0}; //rows that are fully written
+    std::atomic<uint64_t> epoch{1};
+    /* Only used by the writer: the epoch after the last copies were installed, and the rows that were copied since
+     * the store was last seen quiescent. */
+    uint64_t retired = 0;
+    std::size_t preserved_begin = SIZE_MAX, preserved_end = 0;
+    std::atomic<uint64_t> updated{0}; //epoch after the last copies for rows updated in place were installed
+
+    void unpin(const std::shared_ptr<Snapshot::state> &s);
+    bool copy(Snapshot::state &s, std::size_t arena, std::size_t segment);
+    bool reading_before(uint64_t e);
+
+    public:
+    /** Describes the memory of the store.  `attributes` holds, for every attribute and finally for the null bitmaps,
+     * the index of its arena and its layout relative to the beginning of a segment. */
+    void describe(std::vector<arena> arenas, std::vector<std::pair<std::size_t, AttributeLayout>> attributes) {
+        this->arenas = std::move(arenas);
+        this->attributes = std::move(attributes);
+    }
+
+    /** Returns a snapshot of the rows published so far. */
+    Snapshot pin();
+    /** Returns true iff no snapshot is pinned. */
+    bool empty() const { return num_pinned.load() == 0; }
+
+    /** Publishes that the first `num_rows` rows are fully written. */
+    void publish(std::size_t num_rows) { published.store(num_rows); }
+    /** Copies the segments of the rows starting at `num_rows` for every snapshot that sees them and has not copied
+     * them yet, and publishes `num_rows` rows.  Called before the store shrinks to `num_rows` rows. */
+    void preserve(std::size_t num_rows);
+    /** Returns true iff no reader may still read in place a segment that was copied by `preserve()`, so that the
+     * store may release or overwrite the memory of dropped rows. */
+    bool quiescent();
+    /** Waits until `quiescent()` if one of the `n` rows starting at `first_row` was dropped while pinned and may still
+     * be read in place.  Appending rows that no snapshot has seen never waits. */
+    void before_write(std::size_t first_row, std::size_t n);
+    /** Copies the segment of `row` for every snapshot that sees it and has not copied it yet, and waits until no
+     * reader may still read it in place.  Called before the store overwrites `row` in place; several threads may call
+     * it concurrently, if they serialize their writes. */
+    void before_update(std::size_t row);
+};
+
+template<typename F>
+void Snapshot::read(F &&f) const
+{
+    if (not state_) return;
+    state_->reading.store(registry->epoch.load());
+    f();
+    state_->reading.store(0);
+}
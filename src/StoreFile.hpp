@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutable/mutable.hpp>
+
+
+/*
+ * Header at the beginning of the file of a persistent store.
+ * It identifies the kind of store and the layout of its rows by a fingerprint of the attribute types and their
+ * placement, and it keeps the number of rows, which the store updates on every append and drop.  A file can only be
+ * reopened for a table with the same layout.
+ */
+struct StoreFileHeader
+{
+    static constexpr uint64_t MAGIC = 0x31454c4946424453; // "SDBFILE1"
+    /** Bytes reserved for the header in the file, the rows start at the next page. */
+    static constexpr std::size_t SIZE = 4096;
+
+    enum kind_t : uint32_t { ROW_STORE = 1, COLUMN_STORE = 2 };
+
+    uint64_t magic;
+    uint32_t kind;
+    uint32_t num_attributes;
+    uint64_t layout; //fingerprint of the layout
+    uint64_t num_rows;
+
+    /** Extends the fingerprint `layout` of a layout by `value`. */
+    static uint64_t Fingerprint(uint64_t layout, uint64_t value) {
+        // FNV-1a over the bytes of `value`
+        for (unsigned i = 0; i != 8; ++i) {
+            layout ^= (value >> (8 * i)) & 0xff;
+            layout *= 0x100000001b3;
+        }
+        return layout;
+    }
+
+    /** Returns the fingerprint of the type of `attr`, of which the size alone is ambiguous. */
+    static uint64_t Fingerprint(uint64_t layout, const m::Attribute &attr) {
+        uint64_t category = attr.type->is_boolean() ? 1 : attr.type->is_character_sequence() ? 2
+                          : attr.type->is_floating_point() ? 3 : attr.type->is_integral() ? 4 : 0;
+        return Fingerprint(layout, uint64_t(attr.type->size()) << 3 | category);
+    }
+
+    /** The fingerprint of an empty layout. */
+    static constexpr uint64_t EMPTY_LAYOUT = 0xcbf29ce484222325;
+
+    /** Returns the header stored in `data`.  A new file, whose header is all zeros, is initialized as an empty store
+     * of `kind`, otherwise the header must describe a store of `kind` with the given layout. */
+    static StoreFileHeader & Open(char *data, kind_t kind, std::size_t num_attributes, uint64_t layout,
+                                  const char *filename)
+    {
+        auto &header = *reinterpret_cast<StoreFileHeader*>(data);
+        if (header.magic == 0) {
+            header.kind = kind;
+            header.num_attributes = num_attributes;
+            header.layout = layout;
+            header.num_rows = 0;
+            header.magic = MAGIC;
+        } else if (header.magic != MAGIC or header.kind != kind or header.num_attributes != num_attributes or
+                   header.layout != layout) {
+            std::cout << "Error in opening store file " << filename << ": the layout of the table does not match"
+                      << "\n";
+            exit(1);
+        }
+        return header;
+    }
+};
@@ -0,0 +1,297 @@
+/*
+Implementation of the write-ahead log
+*/
+
+#include "WriteAheadLog.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+//reads `bytes` bytes at `offset` of the file, returns false at the end of the file
+bool read_fully(int fd, char *data, std::size_t bytes, uint64_t offset)
+{
+    while(bytes > 0) {
+        ssize_t n = pread(fd, data, bytes, offset);
+        if(n <= 0) return false;
+        data += n;
+        bytes -= n;
+        offset += n;
+    }
+    return true;
+}
+
+//returns the bytes of a row in the log: whole bytes per value followed by the null bitmap
+std::size_t row_bytes(const std::vector<std::size_t> &sizes)
+{
+    std::size_t bytes = (sizes.size() + 7) / 8;
+    for(auto size : sizes) bytes += (size + 7) / 8;
+    return bytes;
+}
+
+//writes the values of `row` to `p`, which must be zeroed, and returns the end of the row
+char * encode(const std::vector<std::size_t> &sizes, const std::vector<AttributeLayout> &layouts, std::size_t row,
+              char *p)
+{
+    auto &bitmap = layouts.back();
+    for(std::size_t attr = 0; attr != sizes.size(); ++attr) {
+        auto &layout = layouts[attr];
+        //booleans are single bits, all other values occupy whole bytes
+        if(sizes[attr] % 8) *p = (*layout.address(row) >> layout.bit(row)) & 1;
+        else std::memcpy(p, layout.address(row), sizes[attr] / 8);
+        p += (sizes[attr] + 7) / 8;
+    }
+    for(std::size_t attr = 0; attr != sizes.size(); ++attr) {
+        const uint64_t bit = bitmap.bit(row) + attr;
+        if((bitmap.address(row)[bit / 8] >> (bit % 8)) & 1) p[attr / 8] |= 1 << (attr % 8);
+    }
+    return p + (sizes.size() + 7) / 8;
+}
+
+//writes the values at `payload` to row `i` of `range` and returns the end of the row
+const char * decode(const std::vector<std::size_t> &sizes, RowRange &range, std::size_t i, const char *payload)
+{
+    for(std::size_t attr = 0; attr != sizes.size(); ++attr) {
+        if(sizes[attr] % 8) range.set(attr, i, bool(payload[0] & 1));
+        else std::memcpy(range.layouts[attr].address(range.first + i), payload, sizes[attr] / 8);
+        payload += (sizes[attr] + 7) / 8;
+    }
+    for(std::size_t attr = 0; attr != sizes.size(); ++attr) {
+        range.set_null(attr, i, not ((payload[attr / 8] >> (attr % 8)) & 1));
+    }
+    return payload + (sizes.size() + 7) / 8;
+}
+
+}
+
+WriteAheadLog::WriteAheadLog(const char *filename, std::chrono::microseconds commit_interval)
+    : interval(commit_interval)
+{
+    fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if(fd == -1) {
+        std::cout << "Error in opening log file " << filename << "\n";
+        exit(1);
+    }
+
+    /*Find the end of the last complete record and discard everything after it. */
+    uint64_t end = 0;
+    replay([&end](const Record &record, const char*) { end += sizeof(Record) + record.payload_bytes; });
+    if(ftruncate(fd, end) != 0) {
+        std::cout << "Error in discarding the incomplete tail of log file " << filename << "\n";
+        exit(1);
+    }
+    written = durable = end;
+
+    /*Sync once per commit interval. */
+    if(interval > NO_GROUP_COMMIT) {
+        flusher = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto next = std::chrono::steady_clock::now() + interval;
+            while(not wake.wait_until(lock, next, [this]() { return stop; })) {
+                flush(lock);
+                next += interval;
+            }
+        });
+    }
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stop = true;
+        flush(lock);
+    }
+    wake.notify_all();
+    if(flusher.joinable()) flusher.join();
+    close(fd);
+}
+
+uint64_t WriteAheadLog::Checksum(const Record &record, const char *payload)
+{
+    //FNV-1a over the header after the checksum and the payload
+    uint64_t h = 0xcbf29ce484222325;
+    auto add = [&h](const char *data, std::size_t bytes) {
+        for(std::size_t i = 0; i != bytes; ++i) {
+            h ^= uint8_t(data[i]);
+            h *= 0x100000001b3;
+        }
+    };
+    add(reinterpret_cast<const char*>(&record) + sizeof(record.checksum), sizeof(Record) - sizeof(record.checksum));
+    add(payload, record.payload_bytes);
+    return h;
+}
+
+void WriteAheadLog::flush(std::unique_lock<std::mutex> &lock)
+{
+    //syncs must not overlap, or a sync could end before the data of an earlier write reached the file
+    while(flushing) synced.wait(lock);
+    if(buffer.empty()) return;
+    flushing = true;
+
+    //write the records collected so far, records that arrive meanwhile go to a new buffer
+    std::vector<char> data;
+    data.swap(buffer);
+    const uint64_t end = written + data.size();
+    written = end;
+    lock.unlock();
+    bool failed = false;
+    for(std::size_t done = 0; done != data.size() && not failed; ) {
+        ssize_t n = pwrite(fd, data.data() + done, data.size() - done, end - data.size() + done);
+        failed = n <= 0;
+        done += failed ? 0 : n;
+    }
+    if(failed || fdatasync(fd) != 0) {
+        std::cout << "Error in writing the log" << "\n";
+        exit(1);
+    }
+    lock.lock();
+    durable = end;
+    flushing = false;
+    syncs++;
+    synced.notify_all();
+}
+
+uint64_t WriteAheadLog::append(uint32_t store, kind_t kind, uint64_t first_row, uint64_t num_rows,
+                               const std::vector<char> &payload)
+{
+    Record record{ 0, store, kind, first_row, num_rows, payload.size() };
+    record.checksum = Checksum(record, payload.data());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const char *header = reinterpret_cast<const char*>(&record);
+    buffer.insert(buffer.end(), header, header + sizeof(Record));
+    buffer.insert(buffer.end(), payload.begin(), payload.end());
+    return written + buffer.size();
+}
+
+void WriteAheadLog::commit(uint64_t lsn)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if(interval == NO_GROUP_COMMIT) {
+        //a sync that is in progress may not include the record, sync again
+        while(durable < lsn) flush(lock);
+        return;
+    }
+    //the flusher syncs the record within the commit interval, together with the records of other commits
+    while(durable < lsn) synced.wait(lock);
+}
+
+void WriteAheadLog::replay(const std::function<void(const Record&, const char*)> &callback)
+{
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        std::cout << "Error in reading the log" << "\n";
+        exit(1);
+    }
+    const uint64_t file_bytes = st.st_size;
+    uint64_t offset = 0;
+    Record record;
+    std::vector<char> payload;
+    while(read_fully(fd, reinterpret_cast<char*>(&record), sizeof(Record), offset)) {
+        //the size of a torn header is garbage, check it before allocating the payload
+        if(record.payload_bytes > file_bytes - offset - sizeof(Record)) break;
+        payload.resize(record.payload_bytes);
+        if(not read_fully(fd, payload.data(), payload.size(), offset + sizeof(Record)) ||
+           Checksum(record, payload.data()) != record.checksum) {
+            break; //a torn record
+        }
+        callback(record, payload.data());
+        offset += sizeof(Record) + record.payload_bytes;
+    }
+}
+
+std::size_t WriteAheadLog::num_syncs()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncs;
+}
+
+void StoreLog::Replay(WriteAheadLog &log, uint32_t id, const std::vector<std::size_t> &sizes, std::size_t num_rows,
+                      const std::function<RowRange(std::size_t)> &append,
+                      const std::function<void(std::size_t)> &truncate,
+                      const std::function<std::vector<AttributeLayout>()> &layouts)
+{
+    const std::size_t bytes = row_bytes(sizes);
+    log.replay([&](const WriteAheadLog::Record &record, const char *payload) {
+        if(record.store != id) return;
+        if(record.kind == WriteAheadLog::TRUNCATE) {
+            if(record.first_row < num_rows) {
+                truncate(record.first_row);
+                num_rows = record.first_row;
+            }
+            return;
+        }
+        if(record.kind == WriteAheadLog::UPDATE) {
+            for(std::size_t i = 0; i != record.num_rows; ++i) {
+                uint64_t row;
+                std::memcpy(&row, payload, sizeof(row));
+                payload += sizeof(row);
+                if(row >= num_rows) {
+                    //rows before it that were not logged yet belong to transactions that did not commit
+                    RowRange range = append(row + 1 - num_rows);
+                    for(std::size_t r = 0; r + 1 < range.num_rows; ++r) {
+                        for(std::size_t attr = 0; attr != sizes.size(); ++attr) range.set_null(attr, r, true);
+                    }
+                    payload = decode(sizes, range, range.num_rows - 1, payload);
+                    num_rows = row + 1;
+                } else {
+                    RowRange range{ row, 1, layouts() };
+                    payload = decode(sizes, range, 0, payload);
+                }
+            }
+            return;
+        }
+        //skip rows the store holds already
+        if(record.first_row + record.num_rows <= num_rows) return;
+        if(record.first_row > num_rows) {
+            std::cout << "Error in replaying the log: rows " << num_rows << " to " << record.first_row
+                      << " are missing" << "\n";
+            exit(1);
+        }
+        std::size_t skip = num_rows - record.first_row;
+        RowRange range = append(record.num_rows - skip);
+        payload += skip * bytes;
+        for(std::size_t i = 0; i != record.num_rows - skip; ++i) {
+            payload = decode(sizes, range, i, payload);
+        }
+        num_rows += record.num_rows - skip;
+    });
+}
+
+void StoreLog::log_rows(const std::vector<AttributeLayout> &layouts, std::size_t num_rows)
+{
+    if(num_rows <= logged) return;
+    std::vector<char> payload((num_rows - logged) * row_bytes(sizes));
+    char *p = payload.data();
+    for(std::size_t row = logged; row != num_rows; ++row) {
+        p = encode(sizes, layouts, row, p);
+    }
+    lsn = log.append(id, WriteAheadLog::APPEND, logged, num_rows - logged, payload);
+    logged = num_rows;
+}
+
+uint64_t StoreLog::log_update(const std::vector<AttributeLayout> &layouts, const std::vector<std::size_t> &rows)
+{
+    std::vector<char> payload(rows.size() * (sizeof(uint64_t) + row_bytes(sizes)));
+    char *p = payload.data();
+    for(std::size_t row : rows) {
+        const uint64_t index = row;
+        std::memcpy(p, &index, sizeof(index));
+        p = encode(sizes, layouts, row, p + sizeof(index));
+    }
+    lsn = log.append(id, WriteAheadLog::UPDATE, 0, rows.size(), payload);
+    return lsn;
+}
+
+void StoreLog::log_truncate(std::size_t num_rows)
+{
+    if(num_rows >= logged) return; //the dropped rows were never logged
+    lsn = log.append(id, WriteAheadLog::TRUNCATE, num_rows, 0, {});
+    logged = num_rows;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "RowRange.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+/*
+ * Append-only redo log in a file, shared by the stores that log to it.
+ * Records are collected in a buffer and written to the file in batches.  A record is durable once the file was synced
+ * after it was written.  With a commit interval, a background thread syncs the file once per interval and every
+ * commit waits for the next sync, so that concurrent commits share a single sync (group commit).  Without a commit
+ * interval, every commit syncs the file itself.
+ * Every record carries a checksum; a torn record at the end of the file, left by a crash, is discarded when the log is
+ * opened.
+ */
+struct WriteAheadLog
+{
+    enum kind_t : uint32_t {
+        APPEND = 1, ///< rows appended to a store, the payload holds their values
+        TRUNCATE = 2, ///< rows dropped from a store, which keeps `first_row` rows
+        UPDATE = 3, ///< `num_rows` rows changed in place, the payload holds the index and the values of each
+    };
+
+    struct Record
+    {
+        uint64_t checksum; //of the rest of the header and the payload
+        uint32_t store; //id of the logging store
+        uint32_t kind;
+        uint64_t first_row;
+        uint64_t num_rows;
+        uint64_t payload_bytes;
+    };
+
+    /** Commit interval of a log that syncs on every commit. */
+    static constexpr std::chrono::microseconds NO_GROUP_COMMIT{0};
+
+    private:
+    int fd;
+    std::chrono::microseconds interval;
+    std::mutex mutex; //protects all following members
+    std::condition_variable synced; //notified whenever a sync ends
+    std::condition_variable wake; //wakes the flusher to stop
+    std::vector<char> buffer; //records that are not written to the file yet
+    uint64_t written; //bytes of records written to the file, the log sequence number of `buffer`
+    uint64_t durable; //bytes of records that are synced
+    std::size_t syncs = 0;
+    bool flushing = false; //true while a sync is in progress
+    bool stop = false;
+    std::thread flusher;
+
+    static uint64_t Checksum(const Record &record, const char *payload);
+    /** Writes the buffer to the file and syncs it, after a sync in progress ended.  Called with `lock` held, which is
+     * released while syncing. */
+    void flush(std::unique_lock<std::mutex> &lock);
+
+    public:
+    /** Opens or creates the log in the file `filename`.  Commits wait for a sync that happens at most
+     * `commit_interval` later. */
+    WriteAheadLog(const char *filename, std::chrono::microseconds commit_interval = NO_GROUP_COMMIT);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+
+    /** Adds a record of `kind` for the store with id `store` and returns its log sequence number, the position of the
+     * end of the record in the log.  The record is durable once `commit()` returns for that number. */
+    uint64_t append(uint32_t store, kind_t kind, uint64_t first_row, uint64_t num_rows,
+                    const std::vector<char> &payload);
+    /** Waits until all records up to log sequence number `lsn` are durable. */
+    void commit(uint64_t lsn);
+
+    /** Calls `callback(record, payload)` for every record in the file, in log order. */
+    void replay(const std::function<void(const Record&, const char*)> &callback);
+
+    /** Returns the number of times the file was synced. */
+    std::size_t num_syncs();
+};
+
+/*
+ * The redo logging of a single store.
+ * A store logs the values of its rows once they are written, which is when the next rows are appended or when the
+ * store commits, and logs a truncation when it drops rows that were logged.  A transaction layer on top of the store
+ * logs the rows it inserted and updated itself, once they are committed.  Values are logged independently of the
+ * layout of the store: every value occupies whole bytes and every row ends with the bytes of its null bitmap.
+ */
+struct StoreLog
+{
+    private:
+    WriteAheadLog &log;
+    uint32_t id;
+    std::vector<std::size_t> sizes; //bits of every attribute
+    std::size_t logged = 0; //rows whose values are logged
+    uint64_t lsn = 0; //log sequence number of the last record of the store
+
+    public:
+    /** Written rows are logged in batches of this many rows, or fewer on commit. */
+    static constexpr std::size_t BATCH_ROWS = 1024;
+
+    /** Logs to `log` as the store with id `id`, whose attributes have `sizes` bits and which holds `num_rows` rows
+     * already logged. */
+    StoreLog(WriteAheadLog &log, uint32_t id, std::vector<std::size_t> sizes, std::size_t num_rows)
+        : log(log), id(id), sizes(std::move(sizes)), logged(num_rows)
+    { }
+
+    /** Replays the records of store `id` in `log`.  `append(n)` must append `n` rows and return them for writing,
+     * `truncate(n)` must drop rows until `n` are left, and `layouts()` must return the layouts of the rows of the
+     * store.  Appended rows the store already holds are skipped. */
+    static void Replay(WriteAheadLog &log, uint32_t id, const std::vector<std::size_t> &sizes, std::size_t num_rows,
+                       const std::function<RowRange(std::size_t)> &append,
+                       const std::function<void(std::size_t)> &truncate,
+                       const std::function<std::vector<AttributeLayout>()> &layouts);
+
+    /** Returns the number of rows before `num_rows` that are not logged yet. */
+    std::size_t num_unlogged(std::size_t num_rows) const { return num_rows > logged ? num_rows - logged : 0; }
+    /** Logs the rows after the last logged row up to `num_rows`, which must all be written. */
+    void log_rows(const std::vector<AttributeLayout> &layouts, std::size_t num_rows);
+    /** Logs that the store dropped rows until `num_rows` are left. */
+    void log_truncate(std::size_t num_rows);
+    /** Marks the rows up to `num_rows` as logged without logging them, since a transaction layer logs them. */
+    void skip_rows(std::size_t num_rows) { logged = std::max(logged, num_rows); }
+    /** Logs the values of `rows`, which were inserted or updated in place, and returns the log sequence number of the
+     * record. */
+    uint64_t log_update(const std::vector<AttributeLayout> &layouts, const std::vector<std::size_t> &rows);
+    /** Waits until all records up to log sequence number `lsn` are durable. */
+    void wait_durable(uint64_t lsn) { log.commit(lsn); }
+    /** Logs the rows up to `num_rows` and waits until all records of the store are durable. */
+    void commit(const std::vector<AttributeLayout> &layouts, std::size_t num_rows) {
+        log_rows(layouts, num_rows);
+        log.commit(lsn);
+    }
+};
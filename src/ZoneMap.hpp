@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutable/mutable.hpp>
+#include <type_traits>
+#include <vector>
+
+
+/*
+ * Min/max and number of NULLs of one attribute over a block of rows.
+ * Integral and boolean attributes use `min_i`/`max_i`, floating-point attributes use `min_d`/`max_d`.  Other
+ * attributes only count their NULLs.
+ */
+struct Zone
+{
+    std::size_t num_nulls = 0;
+    bool has_values = false; //false iff every row of the block is NULL
+    int64_t min_i = 0, max_i = 0;
+    double min_d = 0, max_d = 0;
+
+    /** Returns false iff no value of the block lies in [`lo`, `hi`]. */
+    bool may_contain(int64_t lo, int64_t hi) const { return has_values and lo <= max_i and min_i <= hi; }
+    /** Returns false iff no value of the block lies in [`lo`, `hi`]. */
+    bool may_contain(double lo, double hi) const { return has_values and lo <= max_d and min_d <= hi; }
+};
+
+/*
+ * Zone maps of all attributes of a store, one zone per block of `block_rows()` rows.
+ * Values are written by mutable after `m::Store::append()` returns, so a block is summarized once it is sealed, i.e.
+ * when the row following it is appended.  Scans always visit the rows after the last sealed block.
+ */
+struct ZoneMap
+{
+    enum kind_t { OTHER, INTEGRAL, FLOATING, BOOLEAN };
+
+    struct attribute
+    {
+        kind_t kind;
+        uint64_t size; //in bits
+    };
+
+    static constexpr std::size_t DEFAULT_BLOCK_ROWS = 4096;
+
+    private:
+    std::vector<attribute> attributes;
+    std::vector<std::vector<Zone>> zones; //sealed zones of every attribute, in row order
+    std::size_t block_rows_;
+    std::size_t num_blocks_; //number of sealed blocks
+
+    /** Returns true iff attribute `a` of `row` is NULL. */
+    template<typename Locate>
+    bool is_null(std::size_t a, std::size_t row, Locate &locate) const {
+        auto [bitmap, bitmap_bit] = locate(attributes.size(), row);
+        const std::size_t bit = bitmap_bit + a;
+        return not ((bitmap[bit / 8] >> (bit % 8)) & 1);
+    }
+
+    /** Extends `zone` of attribute `a` by the value of `row`, which is not NULL. */
+    template<typename Locate>
+    void add(Zone &zone, std::size_t a, std::size_t row, Locate &locate) const {
+        auto [p, p_bit] = locate(a, row);
+        if (attributes[a].kind == FLOATING) {
+            double v;
+            if (attributes[a].size == 32) { float f; std::memcpy(&f, p, sizeof(f)); v = f; }
+            else std::memcpy(&v, p, sizeof(v));
+            zone.min_d = zone.has_values ? std::min(zone.min_d, v) : v;
+            zone.max_d = zone.has_values ? std::max(zone.max_d, v) : v;
+        } else if (attributes[a].kind != OTHER) {
+            int64_t v;
+            switch (attributes[a].kind == BOOLEAN ? 1 : attributes[a].size) {
+                case 1:  v = (p[p_bit / 8] >> (p_bit % 8)) & 1; break;
+                case 8:  { int8_t i;  std::memcpy(&i, p, sizeof(i)); v = i; break; }
+                case 16: { int16_t i; std::memcpy(&i, p, sizeof(i)); v = i; break; }
+                case 32: { int32_t i; std::memcpy(&i, p, sizeof(i)); v = i; break; }
+                default: std::memcpy(&v, p, sizeof(v)); break;
+            }
+            zone.min_i = zone.has_values ? std::min(zone.min_i, v) : v;
+            zone.max_i = zone.has_values ? std::max(zone.max_i, v) : v;
+        }
+        zone.has_values = true;
+    }
+
+    public:
+    ZoneMap(const m::Table &table, std::size_t block_rows = DEFAULT_BLOCK_ROWS)
+        : block_rows_(block_rows), num_blocks_(0)
+    {
+        for (auto &attr : table) {
+            kind_t kind = OTHER;
+            if (attr.type->is_boolean()) kind = BOOLEAN;
+            else if (attr.type->is_integral()) kind = INTEGRAL;
+            else if (attr.type->is_floating_point()) kind = FLOATING;
+            attributes.push_back(attribute{ kind, attr.type->size() });
+        }
+        zones.resize(attributes.size());
+    }
+
+    std::size_t block_rows() const { return block_rows_; }
+    /** Returns the number of sealed blocks. */
+    std::size_t num_blocks() const { return num_blocks_; }
+    /** Returns the zones of the attribute with index `attr`, one per sealed block. */
+    const std::vector<Zone> & zones_of(std::size_t attr) const { return zones.at(attr); }
+
+    /** Summarizes the next block.  `locate(attr, row)` returns the address and bit offset of the value of `attr` in
+     * `row`; `locate(num_attributes, row)` returns the address and bit offset of the null bitmap of `row`, where a set
+     * bit marks a present value. */
+    template<typename Locate>
+    void seal(Locate &&locate) {
+        const std::size_t first = num_blocks() * block_rows_;
+        for (std::size_t a = 0; a != attributes.size(); ++a) {
+            Zone zone;
+            for (std::size_t row = first; row != first + block_rows_; ++row) {
+                if (is_null(a, row, locate)) ++zone.num_nulls;
+                else add(zone, a, row, locate);
+            }
+            zones[a].push_back(zone);
+        }
+        ++num_blocks_;
+    }
+
+    /** Widens the zone of attribute `attr` of the block of `row`, if it is sealed, so that it covers the value `row`
+     * holds now.  Called after a row of a sealed block was overwritten in place.  Zones never narrow, so a scan may
+     * visit a block that no longer holds a matching value, and the NULL count is the one of the sealed block. */
+    template<typename Locate>
+    void widen(std::size_t attr, std::size_t row, Locate &&locate) {
+        if (row / block_rows_ >= num_blocks_ or is_null(attr, row, locate)) return;
+        add(zones[attr][row / block_rows_], attr, row, locate);
+    }
+
+    /** Discards the zones of blocks that are no longer complete after the store shrank to `num_rows` rows. */
+    void truncate(std::size_t num_rows) {
+        num_blocks_ = std::min(num_blocks_, num_rows / block_rows_);
+        for (auto &z : zones) z.resize(num_blocks_);
+    }
+
+    /** Calls `callback(first_row, num_rows)` for every maximal run of rows of the first `num_rows` rows, whose zones
+     * of `attr` may contain a value in [`lo`, `hi`]. */
+    template<typename T, typename Callback>
+    void scan(std::size_t attr, T lo, T hi, std::size_t num_rows, Callback &&callback) const {
+        const kind_t kind = attributes.at(attr).kind;
+        auto may_contain = [kind, lo, hi](const Zone &zone) {
+            if (kind == OTHER) return true;
+            if (kind == FLOATING) return zone.may_contain(double(lo), double(hi));
+            if constexpr (std::is_floating_point_v<T>)
+                return zone.may_contain(int64_t(std::floor(lo)), int64_t(std::ceil(hi)));
+            else
+                return zone.may_contain(int64_t(lo), int64_t(hi));
+        };
+
+        std::size_t begin = 0, end = 0; //current run of candidate rows
+        for (auto &zone : zones.at(attr)) {
+            if (may_contain(zone)) {
+                end += block_rows_;
+            } else {
+                if (begin != end) callback(begin, end - begin);
+                begin = end = end + block_rows_;
+            }
+        }
+        if (end < num_rows) end = num_rows; //the rows after the last sealed block are always visited
+        if (begin != end) callback(begin, end - begin);
+    }
+};
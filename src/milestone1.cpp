@@ -2,7 +2,10 @@
 Checks the implementation of the row and colum store layouts
 */
 
+#include "CSVLoader.hpp"
 #include "ColumnStore.hpp"
+#include "ColumnGroupStore.hpp"
+#include "PaxStore.hpp"
 #include "RowStore.hpp"
 #include <cerrno>
 #include <cstddef>
@@ -30,11 +33,17 @@ int main(int argc, const char **argv)
     /* Register our store(s) and set the default store. */
     C.register_store<RowStore>(C.pool("MyRowStore"));
     C.register_store<ColumnStore>(C.pool("MyColStore"));
+    C.register_store<PaxStore>(C.pool("MyPaxStore"));
+    C.register_store<ColumnGroupStore>(C.pool("MyColumnGroupStore"));
 
     if (streq(argv[1], "row"))
         C.default_store(C.pool("MyRowStore"));
     else if (streq(argv[1], "column"))
         C.default_store(C.pool("MyColStore"));
+    else if (streq(argv[1], "pax"))
+        C.default_store(C.pool("MyPaxStore"));
+    else if (streq(argv[1], "group"))
+        C.default_store(C.pool("MyColumnGroupStore"));
     else {
         std::cerr << "Unknown data layout '" << argv[1] << '\'' << std::endl;
         exit(EXIT_FAILURE);
@@ -55,11 +64,24 @@ int main(int argc, const char **argv)
     T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
     T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
 
-    /* Back the table with our store. */
-    T.store(C.create_store(T));
+    /* Back the table with our store.  Column groups are proposed from the attributes accessed by the SQL file. */
+    if (streq(argv[1], "group")) {
+        std::ifstream sql(argv[3]);
+        auto groups = ColumnGroupStore::Propose(T, ColumnGroupStore::ReadQueryLog(T, sql));
+        T.store(std::make_unique<ColumnGroupStore>(T, groups));
+    } else {
+        T.store(C.create_store(T));
+    }
 
-    /* Load CSV file into table 'T'. */
-    m::load_from_CSV(diag, T, argv[2], std::numeric_limits<std::size_t>::max(), true, false);
+    /* Load CSV file into table 'T', in parallel for the stores that append rows in bulk. */
+    if (streq(argv[1], "row"))
+        CSVLoader::Load(diag, static_cast<RowStore&>(T.store()), argv[2]);
+    else if (streq(argv[1], "column"))
+        CSVLoader::Load(diag, static_cast<ColumnStore&>(T.store()), argv[2]);
+    else if (streq(argv[1], "group"))
+        CSVLoader::Load(diag, static_cast<ColumnGroupStore&>(T.store()), argv[2]);
+    else
+        m::load_from_CSV(diag, T, argv[2], std::numeric_limits<std::size_t>::max(), true, false);
 
     if (diag.num_errors())
         exit(EXIT_FAILURE);
@@ -3,6 +3,8 @@ Checks the implementation of the B+ Tree
 */
 
 #include "BPlusTree.hpp"
+#include "CSVLoader.hpp"
+#include "ColumnStore.hpp"
 #include <memory>
 #include <mutable/mutable.hpp>
 #include <utility>
@@ -45,11 +47,11 @@ int main(int argc, char **argv)
     T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
     T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
 
-    /* Back the table with our store. */
-    T.store(C.create_store(T));
+    /* Back the table with our column store. */
+    T.store(std::make_unique<ColumnStore>(T));
 
-    /* Load CSV file into table 'T'. */
-    m::load_from_CSV(diag, T, argv[1], std::numeric_limits<std::size_t>::max(), true, false);
+    /* Load CSV file into table 'T', parsing chunks of the file in parallel. */
+    CSVLoader::Load(diag, static_cast<ColumnStore&>(T.store()), argv[1]);
 
     if (diag.num_errors())
         exit(EXIT_FAILURE);
@@ -0,0 +1,192 @@
+#include "catch.hpp"
+
+#include "AdaptiveRadixTree.hpp"
+#include <array>
+#include <random>
+#include <vector>
+
+
+#define ART_SECTION(KEY_TYPE, VALUE_TYPE) \
+    DYNAMIC_SECTION(#KEY_TYPE "  -->  " #VALUE_TYPE)
+
+
+namespace {
+
+template<typename key_type, typename value_type>
+void __test_point_lookup()
+{
+    using art_type = AdaptiveRadixTree<key_type, value_type>;
+
+    SECTION("empty")
+    {
+        std::array<typename art_type::value_type, 0> data;
+        auto tree = art_type::Bulkload(data);
+
+        CHECK(tree.size() == 0);
+        CHECK(tree.begin() == tree.end());
+        CHECK(tree.find(42) == tree.end());
+    }
+
+    SECTION("one")
+    {
+        std::array<typename art_type::value_type, 1> data = { {
+            { 42, 13 },
+        } };
+        auto tree = art_type::Bulkload(data);
+
+        CHECK(tree.size() == 1);
+        {
+            auto it = tree.find(42);
+            REQUIRE(it != tree.end());
+            CHECK(it->first == 42);
+            CHECK(it->second == 13);
+        }
+        CHECK(tree.find(0) == tree.end());
+        CHECK(tree.find(137) == tree.end());
+    }
+
+    SECTION("consecutive")
+    {
+        std::vector<typename art_type::value_type> data;
+        for (key_type i = 0; i != 100; ++i) {
+            data.emplace_back(i, i*i);
+        }
+        auto tree = art_type::Bulkload(data);
+
+        for (key_type i = 0; i != 100; ++i) {
+            auto it = tree.find(i);
+            REQUIRE(it != tree.end());
+            CHECK(it->first == i);
+            CHECK(it->second == i*i);
+        }
+        CHECK(tree.find(-1) == tree.end());
+        CHECK(tree.find(100) == tree.end());
+    }
+
+    SECTION("sparse with duplicates")
+    {
+        /* Spread keys over the whole domain to exercise all node kinds and path compression. */
+        std::mt19937 g(42);
+        std::uniform_int_distribution<key_type> dist_key;
+        std::vector<key_type> keys;
+        for (std::size_t i = 0; i != 5000; ++i)
+            keys.push_back(i % 3 == 0 ? dist_key(g) : key_type(i / 2));
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<typename art_type::value_type> data;
+        for (std::size_t i = 0; i != keys.size(); ++i)
+            data.emplace_back(keys[i], value_type(i));
+        auto tree = art_type::Bulkload(data);
+        CHECK(tree.size() == keys.size());
+
+        for (std::size_t i = 0; i != keys.size(); ++i) {
+            auto it = tree.find(keys[i]);
+            REQUIRE(it != tree.end());
+            CHECK(it->first == keys[i]);
+            /* `find` must return the first of all entries with that key */
+            CHECK(std::size_t(it->second) == std::size_t(std::lower_bound(keys.begin(), keys.end(), keys[i]) - keys.begin()));
+        }
+
+        for (std::size_t i = 0; i != 1000; ++i) {
+            const key_type k = dist_key(g);
+            const bool contained = std::binary_search(keys.begin(), keys.end(), k);
+            CHECK((tree.find(k) != tree.end()) == contained);
+        }
+    }
+}
+
+template<typename key_type, typename value_type>
+void __test_range_lookup()
+{
+    using art_type = AdaptiveRadixTree<key_type, value_type>;
+
+    SECTION("empty")
+    {
+        std::array<typename art_type::value_type, 0> data;
+        auto tree = art_type::Bulkload(data);
+
+        CHECK(tree.in_range(0, 42).empty());
+    }
+
+    SECTION("two")
+    {
+        std::array<typename art_type::value_type, 2> data = { {
+            {  42, 13 },
+            { 137, 16 },
+        } };
+        auto tree = art_type::Bulkload(data);
+
+        CHECK(tree.in_range(0, 42).empty());
+        CHECK(tree.in_range(43, 137).empty());
+        CHECK(tree.in_range(138, 200).empty());
+
+        {
+            auto range = tree.in_range(42, 138);
+            REQUIRE_FALSE(range.empty());
+            auto it = range.begin();
+            CHECK(it->first == 42);
+            CHECK(it->second == 13);
+            ++it;
+            REQUIRE(it != range.end());
+            CHECK(it->first == 137);
+            CHECK(it->second == 16);
+            ++it;
+            CHECK(it == range.end());
+        }
+    }
+
+    SECTION("sparse with duplicates")
+    {
+        std::mt19937 g(42);
+        std::uniform_int_distribution<key_type> dist_key;
+        std::vector<key_type> keys;
+        for (std::size_t i = 0; i != 5000; ++i)
+            keys.push_back(i % 2 == 0 ? dist_key(g) : key_type(i / 4));
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<typename art_type::value_type> data;
+        for (auto k : keys)
+            data.emplace_back(k, value_type(0));
+        auto tree = art_type::Bulkload(data);
+
+        for (std::size_t i = 0; i != 1000; ++i) {
+            key_type lo = dist_key(g), hi = dist_key(g);
+            if (hi < lo) std::swap(lo, hi);
+            auto range = tree.in_range(lo, hi);
+            auto first = std::lower_bound(keys.begin(), keys.end(), lo);
+            auto last = std::lower_bound(keys.begin(), keys.end(), hi);
+            CHECK(std::size_t(range.end() - range.begin()) == std::size_t(last - first));
+            if (not range.empty())
+                CHECK(range.begin()->first == *first);
+        }
+    }
+}
+
+}
+
+
+TEST_CASE("AdaptiveRadixTree/point lookup", "[milestone2]")
+{
+#define TEST(KEY_TYPE, VALUE_TYPE) \
+    ART_SECTION(KEY_TYPE, VALUE_TYPE) { __test_point_lookup<KEY_TYPE, VALUE_TYPE>(); }
+
+    TEST(int32_t, int32_t);
+    TEST(int32_t, int64_t);
+    TEST(int64_t, int32_t);
+    TEST(int64_t, int64_t);
+
+#undef TEST
+}
+
+TEST_CASE("AdaptiveRadixTree/range lookup", "[milestone2]")
+{
+#define TEST(KEY_TYPE, VALUE_TYPE) \
+    ART_SECTION(KEY_TYPE, VALUE_TYPE) { __test_range_lookup<KEY_TYPE, VALUE_TYPE>(); }
+
+    TEST(int32_t, int32_t);
+    TEST(int32_t, int64_t);
+    TEST(int64_t, int32_t);
+    TEST(int64_t, int64_t);
+
+#undef TEST
+}
@@ -2,6 +2,7 @@
 
 #include "BPlusTree.hpp"
 // #include "BPlusTree-todo.hpp"
+#include <algorithm>
 #include <array>
 #include <typeinfo>
 #include <vector>
@@ -297,6 +298,69 @@ void __test_range_lookup()
     }
 }
 
+template<typename key_type, typename value_type>
+void __test_range_scan()
+{
+    using btree_type = BPlusTree<key_type, value_type>;
+
+    SECTION("empty")
+    {
+        std::array<typename btree_type::value_type, 0> data;
+        auto tree = btree_type::Bulkload(data);
+
+        std::size_t num_chunks = 0;
+        tree.scan(0, 42, [&](const typename btree_type::chunk&) { ++num_chunks; });
+        CHECK(num_chunks == 0);
+    }
+
+    SECTION("consecutive")
+    {
+        std::vector<typename btree_type::value_type> data;
+        for (typename btree_type::key_type i = 0; i != 100; ++i) {
+            data.emplace_back(i, i*i);
+        }
+        auto tree = btree_type::Bulkload(data);
+
+        {
+            std::size_t num_chunks = 0;
+            tree.scan(100, 200, [&](const typename btree_type::chunk&) { ++num_chunks; });
+            CHECK(num_chunks == 0);
+        }
+
+        {
+            std::size_t num_chunks = 0;
+            typename btree_type::key_type runner = 0;
+            tree.scan(0, 100, [&](const typename btree_type::chunk &c) {
+                REQUIRE_FALSE(c.empty());
+                ++num_chunks;
+                for (std::size_t i = 0; i != c.size(); ++i, ++runner) {
+                    CHECK(c.key(i) == runner);
+                    CHECK(c.value(i) == runner * runner);
+                }
+            });
+            CHECK(runner == 100);
+
+            std::size_t num_leaves = 0;
+            for (auto leaf_it = tree.leaves_begin(), leaf_end = tree.leaves_end(); leaf_it != leaf_end; ++leaf_it)
+                ++num_leaves;
+            CHECK(num_chunks == num_leaves);
+        }
+
+        {
+            typename btree_type::key_type runner = 13;
+            tree.scan(13, 87, [&](const typename btree_type::chunk &c) {
+                REQUIRE_FALSE(c.empty());
+                for (auto &e : c) {
+                    CHECK(e.first == runner);
+                    CHECK(e.second == runner * runner);
+                    ++runner;
+                }
+            });
+            CHECK(runner == 87);
+        }
+    }
+}
+
 }
 
 
@@ -342,6 +406,99 @@ TEST_CASE("BPlusTree/point lookup", "[milestone2]")
 #undef TEST
 }
 
+TEST_CASE("BPlusTree/point lookup with filter", "[milestone2]")
+{
+    using btree_type = BPlusTree<int32_t, int32_t>;
+
+    std::vector<typename btree_type::value_type> data;
+    for (int32_t i = 0; i != 10000; ++i) {
+        data.emplace_back(2*i, i); // only even keys
+    }
+    auto tree = btree_type::Bulkload(data, 10);
+    REQUIRE(tree.filter().enabled());
+
+    /* The filter must not have false negatives. */
+    for (int32_t i = 0; i != 10000; ++i) {
+        auto it = tree.find(2*i);
+        REQUIRE(it != tree.end());
+        CHECK(it->second == i);
+    }
+
+    /* Odd keys are missing; with 10 bits per key, only few of them may pass the filter. */
+    std::size_t num_false_positives = 0;
+    for (int32_t i = 0; i != 10000; ++i) {
+        CHECK(tree.find(2*i + 1) == tree.end());
+        num_false_positives += tree.filter().may_contain(2*i + 1);
+    }
+    CHECK(num_false_positives < 300);
+}
+
+TEST_CASE("BPlusTree/branchless lower bound", "[milestone2]")
+{
+    using btree_type = BPlusTree<int32_t, int32_t>;
+
+    std::vector<int32_t> keys;
+    for (int32_t n = 0; n != 40; ++n) {
+        for (int32_t k = -1; k <= 2 * n + 1; ++k) {
+            auto expected = std::lower_bound(keys.begin(), keys.end(), k) - keys.begin();
+            CHECK(btree_type::branchless_lower_bound(keys.data(), keys.size(), k) == std::size_t(expected));
+        }
+        keys.push_back(2 * n); // keys 0, 2, 4, ...
+    }
+}
+
+TEST_CASE("BPlusTree/duplicates", "[milestone2]")
+{
+    using btree_type = BPlusTree<int32_t, int32_t>;
+
+    /* Repeat every key more often than a leaf can hold, so runs of equal keys straddle leaves and separators. */
+    for (int32_t repetitions : { 2, 3, 5, 7, 13 }) {
+        DYNAMIC_SECTION("repetitions " << repetitions)
+        {
+            std::vector<typename btree_type::value_type> data;
+            for (int32_t k = 0; k != 200; ++k) {
+                for (int32_t r = 0; r != repetitions; ++r)
+                    data.emplace_back(k, int32_t(data.size()));
+            }
+            auto tree = btree_type::Bulkload(data);
+            const auto &const_tree = tree;
+
+            for (int32_t k = 0; k != 200; ++k) {
+                /* `find` must return the first of all entries with key `k` */
+                auto it = tree.find(k);
+                REQUIRE(it != tree.end());
+                CHECK(it->first == k);
+                CHECK(it->second == k * repetitions);
+
+                auto cit = const_tree.find(k);
+                REQUIRE(cit != const_tree.end());
+                CHECK(cit->second == k * repetitions);
+
+                /* the range must contain all entries with key `k` */
+                auto range = tree.in_range(k, k + 1);
+                int32_t count = 0;
+                for (auto e : range) {
+                    CHECK(e.first == k);
+                    CHECK(e.second == k * repetitions + count);
+                    ++count;
+                }
+                CHECK(count == repetitions);
+
+                auto const_range = const_tree.in_range(k, k + 1);
+                count = 0;
+                for (auto it = const_range.begin(); it != const_range.end(); ++it)
+                    ++count;
+                CHECK(count == repetitions);
+            }
+
+            CHECK(tree.find(-1) == tree.end());
+            CHECK(tree.find(200) == tree.end());
+            CHECK(const_tree.find(200) == const_tree.end());
+            CHECK(tree.in_range(200, 300).empty());
+        }
+    }
+}
+
 TEST_CASE("BPlusTree/range lookup", "[milestone2]")
 {
 #define TEST(KEY_TYPE, VALUE_TYPE) \
@@ -355,6 +512,19 @@ TEST_CASE("BPlusTree/range lookup", "[milestone2]")
 #undef TEST
 }
 
+TEST_CASE("BPlusTree/range scan", "[milestone2]")
+{
+#define TEST(KEY_TYPE, VALUE_TYPE) \
+    BTREE_SECTION(KEY_TYPE, VALUE_TYPE) { __test_range_scan<KEY_TYPE, VALUE_TYPE>(); }
+
+    TEST(int32_t, int32_t);
+    TEST(int32_t, int64_t);
+    TEST(int64_t, int32_t);
+    TEST(int64_t, int64_t);
+
+#undef TEST
+}
+
 TEST_CASE("BPlusTree/ISAM", "[milestone2]")
 {
     using btree_type = BPlusTree<int32_t, int32_t>;
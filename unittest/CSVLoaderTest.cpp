@@ -0,0 +1,172 @@
+#include "catch.hpp"
+
+#include "CSVLoader.hpp"
+#include "ColumnStore.hpp"
+#include "RowStore.hpp"
+#include <cstdio>
+#include <fstream>
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <string>
+#include <utility>
+
+
+namespace {
+
+/* Large enough to be split into several chunks. */
+constexpr std::size_t NUM_RECORDS = 200000;
+
+const char *descriptions[] = {
+    "plain", "\"with, comma\"", "\"with\nline break\"", "\"with \"\"quotes\"\"\"", "\"\\\"escaped\\\" quotes\"", "",
+};
+const char *expected[] = { "plain", "with, comma", "with\nline break", "with \"quotes\"", "\"escaped\" quotes", nullptr };
+constexpr std::size_t NUM_DESCRIPTIONS = sizeof(descriptions) / sizeof(descriptions[0]);
+
+std::string write_csv()
+{
+    std::string filename = std::string(P_tmpdir) + "/CSVLoaderTest.csv";
+    std::ofstream out(filename);
+    out << "id,description,flag\n";
+    for (std::size_t i = 0; i != NUM_RECORDS; ++i)
+        out << i << ',' << descriptions[i % NUM_DESCRIPTIONS] << ',' << (i % 2 ? "TRUE" : "FALSE")
+            << (i % 3 ? "\n" : "\r\n");
+    return filename;
+}
+
+template<typename Store>
+void __test_load()
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),          m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("description"), m::Type::Get_Char(m::Type::TY_Vector, 20));
+    table.push_back(C.pool("flag"),        m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<Store>(table));
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    const std::string filename = write_csv();
+    auto &store = static_cast<Store&>(table.store());
+    CHECK(CSVLoader(diag, filename.c_str(), true, 4).num_chunks() == 4);
+    REQUIRE(CSVLoader::Load(diag, store, filename.c_str(), true, 4) == NUM_RECORDS);
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(store.num_rows() == NUM_RECORDS);
+    std::remove(filename.c_str());
+
+    C.set_database_in_use(DB);
+    auto stmt = m::statement_from_string(diag, "SELECT id, description, flag FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == int64_t(num_tuples));
+        if (expected[num_tuples % NUM_DESCRIPTIONS])
+            CHECK(std::string(expected[num_tuples % NUM_DESCRIPTIONS]) == reinterpret_cast<char*>(T.get(1).as_p()));
+        else
+            CHECK(T.is_null(1));
+        CHECK(T.get(2).as_b() == bool(num_tuples % 2));
+        ++num_tuples;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == NUM_RECORDS);
+}
+
+}
+
+TEST_CASE("CSVLoader/RowStore", "[milestone1]")
+{
+    __test_load<RowStore>();
+}
+
+TEST_CASE("CSVLoader/ColumnStore", "[milestone1]")
+{
+    __test_load<ColumnStore>();
+}
+
+TEST_CASE("CSVLoader/header", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),          m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("description"), m::Type::Get_Char(m::Type::TY_Vector, 20));
+    table.push_back(C.pool("flag"),        m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    /* Fields are matched to attributes by name, attributes without a field are NULL, and blank lines at the end of
+     * the file hold no record. */
+    const std::string filename = std::string(P_tmpdir) + "/CSVLoaderTest.csv";
+    {
+        std::ofstream out(filename);
+        out << "flag,id\n";
+        for (std::size_t i = 0; i != 100; ++i)
+            out << (i % 2 ? "1" : "0") << ',' << i << '\n';
+        out << "\n\r\n";
+    }
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    REQUIRE(CSVLoader::Load(diag, store, filename.c_str()) == 100);
+    REQUIRE(diag.num_errors() == 0);
+    REQUIRE(store.num_rows() == 100);
+    std::remove(filename.c_str());
+
+    C.set_database_in_use(DB);
+    auto stmt = m::statement_from_string(diag, "SELECT id, description, flag FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &T) {
+        CHECK(T.get(0).as_i() == int64_t(num_tuples));
+        CHECK(T.is_null(1));
+        CHECK(T.get(2).as_b() == bool(num_tuples % 2));
+        ++num_tuples;
+    });
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == 100);
+}
+
+TEST_CASE("CSVLoader/errors", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("flag"), m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<RowStore>(table));
+    auto &store = static_cast<RowStore&>(table.store());
+
+    const std::string filename = std::string(P_tmpdir) + "/CSVLoaderTest.csv";
+    auto load = [&](const char *contents) {
+        {
+            std::ofstream out(filename);
+            out << contents;
+        }
+        std::ostringstream out, err;
+        m::Diagnostic diag(false, out, err);
+        const std::size_t num_rows = CSVLoader::Load(diag, store, filename.c_str());
+        std::remove(filename.c_str());
+        return std::make_pair(num_rows, diag.num_errors());
+    };
+
+    /* Errors are reported and no row is loaded. */
+    CHECK(load("id,size\n1,2\n") == std::make_pair(std::size_t(0), 1u));
+    CHECK(load("id,flag\n1,true\n2,maybe\n3,false\n") == std::make_pair(std::size_t(0), 1u));
+    CHECK(load("id,flag\n1,true\n2\n") == std::make_pair(std::size_t(0), 1u));
+    CHECK(store.num_rows() == 0);
+    CHECK(load("id,flag\n1,true\n2,false\n") == std::make_pair(std::size_t(2), 0u));
+    CHECK(store.num_rows() == 2);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    CHECK(CSVLoader::Load(diag, store, "/nonexistent/CSVLoaderTest.csv") == 0);
+    CHECK(diag.num_errors() == 1);
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include "ColumnCodec.hpp"
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+/** Compresses `data` and checks that decompressing restores it. */
+template<typename T>
+CompressedChunk __test_roundtrip(const std::vector<T> &data, bool is_integral)
+{
+    auto chunk = CompressedChunk::Compress(reinterpret_cast<const char*>(data.data()), data.size(), sizeof(T),
+                                           is_integral);
+    CHECK(chunk.num_rows() == data.size());
+    CHECK(chunk.stride() == sizeof(T));
+    CHECK(chunk.size_in_bytes() <= data.size() * sizeof(T));
+
+    std::vector<T> out(data.size());
+    chunk.decompress(reinterpret_cast<char*>(out.data()));
+    CHECK(std::memcmp(out.data(), data.data(), data.size() * sizeof(T)) == 0);
+    return chunk;
+}
+
+struct char10 { char c[10]; };
+
+}
+
+TEST_CASE("ColumnCodec/plain", "[milestone1]")
+{
+    std::mt19937_64 g(42);
+    std::vector<uint64_t> data(1000);
+    for (auto &v : data) v = g();
+
+    auto chunk = __test_roundtrip(data, false);
+    CHECK(chunk.scheme() == CompressedChunk::PLAIN);
+}
+
+TEST_CASE("ColumnCodec/rle", "[milestone1]")
+{
+    std::vector<int32_t> data;
+    for (int32_t v = 0; v != 10; ++v)
+        data.insert(data.end(), 1000, v * 1000003);
+
+    auto chunk = __test_roundtrip(data, false);
+    CHECK(chunk.scheme() == CompressedChunk::RLE);
+    CHECK(chunk.size_in_bytes() == 10 * (sizeof(int32_t) + sizeof(uint32_t)));
+}
+
+TEST_CASE("ColumnCodec/dictionary", "[milestone1]")
+{
+    const char *names[] = { "core", "extra", "community", "multilib" };
+    std::vector<char10> data(10000);
+    for (std::size_t i = 0; i != data.size(); ++i) {
+        std::memset(data[i].c, 0, sizeof(data[i].c));
+        std::strncpy(data[i].c, names[(i * 7) % 4], sizeof(data[i].c));
+    }
+
+    auto chunk = __test_roundtrip(data, false);
+    CHECK(chunk.scheme() == CompressedChunk::DICTIONARY);
+    /* 2 bits per row and 4 dictionary entries */
+    CHECK(chunk.size_in_bytes() == 4 * sizeof(char10) + (data.size() * 2 + 63) / 64 * sizeof(uint64_t));
+}
+
+TEST_CASE("ColumnCodec/bitpack", "[milestone1]")
+{
+    SECTION("positive")
+    {
+        std::vector<int32_t> data;
+        for (int32_t i = 0; i != 10000; ++i)
+            data.push_back(1000000 + i);
+        auto chunk = __test_roundtrip(data, true);
+        CHECK(chunk.scheme() == CompressedChunk::BITPACK);
+    }
+
+    SECTION("negative")
+    {
+        std::vector<int16_t> data;
+        for (int16_t i = 0; i != 5000; ++i)
+            data.push_back(int16_t(i % 100 - 50) * (i % 3 ? 1 : -1));
+        auto chunk = __test_roundtrip(data, true);
+        CHECK(chunk.scheme() == CompressedChunk::BITPACK);
+    }
+
+    SECTION("full range")
+    {
+        std::vector<int64_t> data = { INT64_MIN, INT64_MAX, 0, -1, 1 };
+        __test_roundtrip(data, true);
+    }
+
+    SECTION("not integral")
+    {
+        std::vector<int32_t> data;
+        for (int32_t i = 0; i != 10000; ++i)
+            data.push_back(1000000 + i);
+        auto chunk = __test_roundtrip(data, false);
+        CHECK(chunk.scheme() == CompressedChunk::PLAIN);
+    }
+}
+
+TEST_CASE("ColumnCodec/empty", "[milestone1]")
+{
+    auto chunk = CompressedChunk::Compress(nullptr, 0, sizeof(int32_t), true);
+    CHECK(chunk.num_rows() == 0);
+    CHECK(chunk.size_in_bytes() == 0);
+}
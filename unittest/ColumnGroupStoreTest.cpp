@@ -0,0 +1,184 @@
+#include "catch.hpp"
+
+#include "ColumnGroupStore.hpp"
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+TEST_CASE("ColumnGroupStore/c'tor", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.push_back(C.pool("d"), m::Type::Get_Char(m::Type::TY_Vector, 3));
+    const std::vector<ColumnGroupStore::group_t> groups{ { 0, 2 }, { 1, 3 } };
+    table.store(std::make_unique<ColumnGroupStore>(table, groups));
+
+    auto &lin = table.store().linearization();
+    CHECK(lin.num_tuples() == 0); // infinite sequence
+    REQUIRE(lin.num_sequences() == 3); // two groups and the null bitmap
+
+    auto root_it = lin.begin();
+    {
+        /* First group holds 'a' and 'c', 'c' is placed first for alignment. */
+        const auto &seq = *root_it++;
+        REQUIRE(seq.is_linearization());
+        CHECK(seq.offset != 0); // address of the first row of the group
+        CHECK(seq.stride == 16); // 4 byte INT, 8 byte DOUBLE, padding
+        auto &group = seq.as_linearization();
+        REQUIRE(group.num_sequences() == 2);
+        auto it = group.begin();
+        CHECK(it->offset == 64);
+        CHECK((it++)->as_attribute().name == C.pool("a"));
+        CHECK(it->offset == 0);
+        CHECK(it->as_attribute().name == C.pool("c"));
+    }
+    {
+        /* Second group holds 'b' and 'd', the boolean is placed after the characters. */
+        const auto &seq = *root_it++;
+        REQUIRE(seq.is_linearization());
+        CHECK(seq.stride == 4); // 1 bit BOOL, 3 byte CHAR(3), padding
+        auto &group = seq.as_linearization();
+        REQUIRE(group.num_sequences() == 2);
+        auto it = group.begin();
+        CHECK(it->offset == 24);
+        CHECK((it++)->as_attribute().name == C.pool("b"));
+        CHECK(it->offset == 0);
+        CHECK(it->as_attribute().name == C.pool("d"));
+    }
+    {
+        /* Null bitmaps are stored in a column of their own. */
+        const auto &seq = *root_it++;
+        REQUIRE(seq.is_linearization());
+        CHECK(seq.stride == 1);
+        auto &bitmap = seq.as_linearization();
+        REQUIRE(bitmap.num_sequences() == 1);
+        CHECK(bitmap.begin()->is_null_bitmap());
+    }
+}
+
+TEST_CASE("ColumnGroupStore/propose", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("packages"));
+    table.push_back(C.pool("id"),          m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("pkg_name"),    m::Type::Get_Char(m::Type::TY_Vector, 32));
+    table.push_back(C.pool("pkg_ver"),     m::Type::Get_Char(m::Type::TY_Vector, 20));
+    table.push_back(C.pool("description"), m::Type::Get_Char(m::Type::TY_Vector, 80));
+    table.push_back(C.pool("size"),        m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("packager"),    m::Type::Get_Char(m::Type::TY_Vector, 32));
+
+    std::istringstream log("SELECT id, size FROM packages WHERE size > 1000;\n"
+                           "SELECT pkg_name, pkg_ver, description FROM packages WHERE pkg_name = \"size\";\n"
+                           "SELECT packages.id FROM packages WHERE packages.size < 10;\n");
+    auto queries = ColumnGroupStore::ReadQueryLog(table, log);
+    REQUIRE(queries.size() == 3);
+    CHECK(queries[0] == ColumnGroupStore::group_t{ 0, 4 });
+    CHECK(queries[1] == ColumnGroupStore::group_t{ 1, 2, 3 });
+    CHECK(queries[2] == ColumnGroupStore::group_t{ 0, 4 });
+
+    auto groups = ColumnGroupStore::Propose(table, queries);
+    REQUIRE(groups.size() == 3);
+    CHECK(groups[0] == ColumnGroupStore::group_t{ 0, 4 });
+    CHECK(groups[1] == ColumnGroupStore::group_t{ 1, 2, 3 });
+    CHECK(groups[2] == ColumnGroupStore::group_t{ 5 }); // never accessed
+
+    /* Only statements reading the table count, and names qualified by another table or declared as aliases are no
+     * attributes of it. */
+    std::istringstream other("SELECT id, size FROM repositories WHERE size > 1000;\n"
+                             "SELECT p.id, r.description FROM packages p, repositories AS r WHERE p.size = r.size;\n"
+                             "SELECT pkg_name AS description, size * 2 FROM packages AS p WHERE p.packager = 'id';\n"
+                             "SELECT COUNT(*) FROM packages;\n");
+    queries = ColumnGroupStore::ReadQueryLog(table, other);
+    REQUIRE(queries.size() == 2);
+    CHECK(queries[0] == ColumnGroupStore::group_t{ 0, 4 });
+    CHECK(queries[1] == ColumnGroupStore::group_t{ 1, 4, 5 });
+
+    /* A query of all attributes does not split groups. */
+    std::istringstream star("SELECT * FROM packages;");
+    groups = ColumnGroupStore::Propose(table, ColumnGroupStore::ReadQueryLog(table, star));
+    REQUIRE(groups.size() == 1);
+    CHECK(groups[0].size() == 6);
+}
+
+TEST_CASE("ColumnGroupStore/access", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+    table.push_back(C.pool("d_d"),  m::Type::Get_Double(m::Type::TY_Vector));
+    const std::vector<ColumnGroupStore::group_t> groups{ { 0, 3 }, { 1, 2 } };
+    table.store(std::make_unique<ColumnGroupStore>(table, groups));
+
+    auto &store = static_cast<ColumnGroupStore&>(table.store());
+    store.reserve(1000);
+
+    /* Append in batches of different sizes. */
+    std::size_t num_rows = 0;
+    for (std::size_t n : { 1, 99, 900 }) {
+        auto range = store.append(n);
+        CHECK(range.first == num_rows);
+        for (std::size_t i = 0; i != n; ++i, ++num_rows) {
+            range.set(0, i, int32_t(num_rows));
+            range.set(1, i, num_rows % 2 == 0);
+            range.set(2, i, "abc", 3, 5);
+            range.set(3, i, double(num_rows) / 2);
+            range.set_null(0, i, false);
+            range.set_null(1, i, num_rows % 7 == 0);
+            range.set_null(2, i, false);
+            range.set_null(3, i, false);
+        }
+    }
+    REQUIRE(store.num_rows() == 1000);
+
+    /* Rows are also appended one at a time through mutable. */
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES ( 1000, TRUE, \"xyz\", 500.0 );");
+    REQUIRE(diag.num_errors() == 0);
+    m::execute_statement(diag, *insertions);
+    REQUIRE(store.num_rows() == 1001);
+
+    auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+        CHECK(T.get(S[C.pool("a_i4")].first).as_i() == int64_t(num_tuples));
+        CHECK(T.get(S[C.pool("d_d")].first).as_d() == double(num_tuples) / 2);
+        if (num_tuples == 1000) {
+            CHECK(T.get(S[C.pool("b_b")].first).as_b());
+            CHECK(std::string("xyz") == reinterpret_cast<char*>(T.get(S[C.pool("c_c5")].first).as_p()));
+        } else {
+            if (num_tuples % 7 == 0)
+                CHECK(T.is_null(S[C.pool("b_b")].first));
+            else
+                CHECK(T.get(S[C.pool("b_b")].first).as_b() == (num_tuples % 2 == 0));
+            CHECK(std::string("abc") == reinterpret_cast<char*>(T.get(S[C.pool("c_c5")].first).as_p()));
+        }
+        ++num_tuples;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == 1001);
+
+    /* Dropping rows keeps the remaining ones. */
+    store.drop();
+    CHECK(store.num_rows() == 1000);
+}
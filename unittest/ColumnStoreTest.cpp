@@ -1,9 +1,16 @@
 #include "catch.hpp"
 
 #include "ColumnStore.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <mutable/mutable.hpp>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 
 TEST_CASE("ColumnStore/c'tor", "[milestone1]")
@@ -18,6 +25,725 @@ TEST_CASE("ColumnStore/c'tor", "[milestone1]")
     /* Root must be an infinite sequence of rows. */
     CHECK(lin.num_tuples() == 0); // infinite sequence
     REQUIRE(lin.num_sequences() == 2); // attribute 'a' and null bitmap
+
+    /* The columns together reserve the given address space, which limits the number of rows. */
+    ColumnStore small(table, AllocationPolicy(), 1 << 24);
+    CHECK(small.row_limit() < ColumnStore::MAX_ROWS);
+    CHECK(small.row_limit() * (4 + 1) <= 1 << 24); // 4 bytes of 'a' and a byte of null bitmap per row
+    small.reserve(small.row_limit());
+    CHECK(small.allocated_rows() >= small.row_limit());
+}
+
+TEST_CASE("ColumnStore/packed booleans", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    store.enable_compression();
+
+    /* The boolean column is a sequence of bytes, each holding eight rows one bit apart; every column covers the
+     * same eight rows per step. */
+    auto &lin = store.linearization();
+    REQUIRE(lin.num_sequences() == 3); // attributes 'a' and 'b' and null bitmap
+    auto it = lin.begin();
+    CHECK(it->stride == 4 * ColumnStore::PACKED_ROWS);
+    CHECK(it->as_linearization().num_tuples() == ColumnStore::PACKED_ROWS);
+    CHECK(it->as_linearization().begin()->stride == 32); // 32 bits per row
+    ++it;
+    CHECK(it->stride == 1);
+    CHECK(it->as_linearization().num_tuples() == ColumnStore::PACKED_ROWS);
+    CHECK(it->as_linearization().begin()->stride == 1); // one bit per row
+    ++it;
+    CHECK(it->stride == ColumnStore::PACKED_ROWS);
+    CHECK(it->as_linearization().num_tuples() == ColumnStore::PACKED_ROWS);
+    CHECK(it->as_linearization().begin()->stride == 8); // a byte of null bits per row
+    CHECK(store.values_per_stride(1) == ColumnStore::PACKED_ROWS);
+
+    /* Rows sharing a byte are written independently. */
+    const std::size_t num_rows = ColumnStore::COMPRESSION_CHUNK_ROWS + 3;
+    auto range = store.append(num_rows);
+    for (std::size_t i = 0; i != num_rows; ++i) {
+        range.set(0, i, int32_t(i));
+        range.set(1, i, i / 3 % 2 == 0);
+        range.set_null(0, i, false);
+        range.set_null(1, i, false);
+    }
+    store.append(); // seals the first chunk
+
+    /* Scans pass eight values per byte, for sealed chunks and the rows after them. */
+    std::size_t row = 0;
+    store.scan(1, [&](const char *values, std::size_t n) {
+        for (std::size_t i = 0; i != n; ++i, ++row) {
+            if (row < num_rows) // the last row is not written
+                CHECK(bool((values[i / 8] >> (i % 8)) & 1) == (row / 3 % 2 == 0));
+        }
+    });
+    CHECK(row == num_rows + 1);
+    CHECK(store.zone_map().zones_of(1)[0].min_i == 0);
+    CHECK(store.zone_map().zones_of(1)[0].max_i == 1);
+}
+
+TEST_CASE("ColumnStore/append", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Char(m::Type::TY_Vector, 32));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = table.store();
+    std::vector<uint64_t> column_addresses;
+    for (auto seq : store.linearization())
+        column_addresses.push_back(seq.offset);
+
+    /* Grow the store across many chunks; columns must never move. */
+    for (std::size_t i = 0; i != 100000; ++i)
+        store.append();
+    CHECK(store.num_rows() == 100000);
+
+    std::size_t i = 0;
+    for (auto seq : store.linearization())
+        CHECK(seq.offset == column_addresses[i++]);
+}
+
+TEST_CASE("ColumnStore/shrink", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Char(m::Type::TY_Vector, 32));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    const uint64_t address = store.linearization().begin()->offset;
+
+    for (std::size_t i = 0; i != 100000; ++i)
+        store.append();
+    const std::size_t peak = store.allocated_rows();
+    REQUIRE(peak >= 100000);
+
+    /* Dropping most rows releases memory. */
+    while (store.num_rows() != 1000)
+        store.drop();
+    const std::size_t shrunk = store.allocated_rows();
+    CHECK(shrunk < peak / 2);
+    CHECK(shrunk >= 1000);
+
+    /* Alternating appends and drops around the new size neither grow nor shrink the store. */
+    for (std::size_t i = 0; i != 100; ++i) {
+        store.append();
+        store.drop();
+    }
+    CHECK(store.allocated_rows() == shrunk);
+
+    /* Released memory is committed again on demand, at the same address. */
+    for (std::size_t i = 0; i != 99000; ++i)
+        store.append();
+    CHECK(store.num_rows() == 100000);
+    CHECK(store.allocated_rows() >= 100000);
+    CHECK(store.linearization().begin()->offset == address);
+}
+
+TEST_CASE("ColumnStore/compression", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),  m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("grp"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = static_cast<ColumnStore&>(table.store());
+    store.enable_compression();
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+
+    /* Fill two and a half chunks; the third chunk is not sealed. */
+    const std::size_t num_rows = ColumnStore::COMPRESSION_CHUNK_ROWS * 5 / 2;
+    for (std::size_t i = 0; i != num_rows; ++i) {
+        tup.set(0, int32_t(i));
+        tup.set(1, int32_t(i / 1000 % 7));
+        W.append(tup);
+    }
+
+    REQUIRE(store.chunks(0).size() == 2);
+    CHECK(store.chunks(0)[0].scheme() == CompressedChunk::BITPACK);
+    CHECK(store.chunks(1)[0].scheme() == CompressedChunk::RLE);
+    CHECK(store.compressed_size_in_bytes() * 4 < store.uncompressed_size_in_bytes());
+
+    /* Scans must restore every value, including the rows after the last sealed chunk. */
+    for (std::size_t attr = 0; attr != 2; ++attr) {
+        std::size_t row = 0;
+        store.scan(attr, [&](const char *values, std::size_t n) {
+            for (std::size_t i = 0; i != n; ++i, ++row) {
+                const int32_t v = reinterpret_cast<const int32_t*>(values)[i];
+                CHECK(v == (attr == 0 ? int32_t(row) : int32_t(row / 1000 % 7)));
+            }
+        });
+        CHECK(row == num_rows);
+    }
+
+    /* Dropping a row of a sealed chunk unseals it. */
+    for (std::size_t i = 0; i != ColumnStore::COMPRESSION_CHUNK_ROWS; ++i)
+        store.drop();
+    CHECK(store.chunks(0).size() == 1);
+}
+
+TEST_CASE("ColumnStore/bulk append", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = static_cast<ColumnStore&>(table.store());
+    store.reserve(1000);
+
+    /* Append in batches of different sizes. */
+    std::size_t num_rows = 0;
+    for (std::size_t n : { 1, 99, 900 }) {
+        auto range = store.append(n);
+        CHECK(range.first == num_rows);
+        CHECK(range.num_rows == n);
+        for (std::size_t i = 0; i != n; ++i, ++num_rows) {
+            range.set(0, i, int32_t(num_rows));
+            range.set(1, i, num_rows % 2 == 0);
+            range.set(2, i, "abc", 3, 5);
+            range.set_null(0, i, false);
+            range.set_null(1, i, num_rows % 7 == 0);
+            range.set_null(2, i, false);
+        }
+    }
+    REQUIRE(store.num_rows() == 1000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+        CHECK(T.get(S[C.pool("a_i4")].first).as_i() == int64_t(num_tuples));
+        if (num_tuples % 7 == 0)
+            CHECK(T.is_null(S[C.pool("b_b")].first));
+        else
+            CHECK(T.get(S[C.pool("b_b")].first).as_b() == (num_tuples % 2 == 0));
+        CHECK(std::string("abc") == reinterpret_cast<char*>(T.get(S[C.pool("c_c5")].first).as_p()));
+        ++num_tuples;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == 1000);
+}
+
+TEST_CASE("ColumnStore/persistent", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+
+    const std::string filename = std::string(P_tmpdir) + "/ColumnStoreTest.store";
+    for (auto suffix : { "", ".0", ".1", ".2" })
+        std::remove((filename + suffix).c_str());
+
+    {
+        /* Fill a new file. */
+        auto store = std::make_unique<ColumnStore>(table, filename.c_str());
+        REQUIRE(store->is_persistent());
+        REQUIRE(store->num_rows() == 0);
+        auto range = store->append(1000);
+        for (std::size_t i = 0; i != 1000; ++i) {
+            range.set(0, i, int32_t(i));
+            range.set(1, i, i % 2 == 0);
+            range.set(2, i, "abc", 3, 5);
+            range.set_null(0, i, false);
+            range.set_null(1, i, i % 7 == 0);
+            range.set_null(2, i, false);
+        }
+        store->drop();
+        store->sync();
+    }
+
+    /* Reopening the file restores all rows. */
+    table.store(std::make_unique<ColumnStore>(table, filename.c_str()));
+    REQUIRE(table.store().num_rows() == 999);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+        CHECK(T.get(S[C.pool("a_i4")].first).as_i() == int64_t(num_tuples));
+        if (num_tuples % 7 == 0)
+            CHECK(T.is_null(S[C.pool("b_b")].first));
+        else
+            CHECK(T.get(S[C.pool("b_b")].first).as_b() == (num_tuples % 2 == 0));
+        CHECK(std::string("abc") == reinterpret_cast<char*>(T.get(S[C.pool("c_c5")].first).as_p()));
+        ++num_tuples;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == 999);
+
+    /* Appending continues after the restored rows. */
+    table.store().append();
+    CHECK(table.store().num_rows() == 1000);
+    for (auto suffix : { "", ".0", ".1", ".2" })
+        std::remove((filename + suffix).c_str());
+}
+
+TEST_CASE("ColumnStore/zone maps", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = static_cast<ColumnStore&>(table.store());
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+
+    /* Fill three blocks and a few rows of a fourth block, which is not sealed. */
+    const std::size_t BLOCK_ROWS = store.zone_map().block_rows();
+    const std::size_t num_rows = 3 * BLOCK_ROWS + 100;
+    for (std::size_t i = 0; i != num_rows; ++i) {
+        tup.set(0, int32_t(i));
+        tup.set(1, double(num_rows - i) / 2);
+        W.append(tup);
+    }
+
+    auto &zones = store.zone_map();
+    REQUIRE(zones.num_blocks() == 3);
+    for (std::size_t b = 0; b != 3; ++b) {
+        const Zone &id = zones.zones_of(0)[b];
+        CHECK(id.num_nulls == 0);
+        CHECK(id.min_i == int64_t(b * BLOCK_ROWS));
+        CHECK(id.max_i == int64_t((b + 1) * BLOCK_ROWS - 1));
+        const Zone &size = zones.zones_of(1)[b];
+        CHECK(size.min_d == double(num_rows - (b + 1) * BLOCK_ROWS + 1) / 2);
+        CHECK(size.max_d == double(num_rows - b * BLOCK_ROWS) / 2);
+    }
+
+    /* A scan for a range inside the second block skips the first and third block, but visits the unsealed rows. */
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    zones.scan(0, int32_t(BLOCK_ROWS + 10), int32_t(BLOCK_ROWS + 20), store.num_rows(),
+               [&](std::size_t first, std::size_t n) { runs.emplace_back(first, n); });
+    REQUIRE(runs.size() == 2);
+    CHECK(runs[0] == std::make_pair(BLOCK_ROWS, BLOCK_ROWS));
+    CHECK(runs[1] == std::make_pair(3 * BLOCK_ROWS, std::size_t(100)));
+
+    /* Dropping a row of a sealed block discards its zone. */
+    for (std::size_t i = 0; i != 101; ++i)
+        store.drop();
+    CHECK(zones.num_blocks() == 2);
+}
+
+TEST_CASE("ColumnStore/zone maps after drop", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<ColumnStore>(table));
+
+    auto &store = static_cast<ColumnStore&>(table.store());
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+
+    /* Fill two blocks and one row of a third block. */
+    const std::size_t BLOCK_ROWS = store.zone_map().block_rows();
+    for (std::size_t i = 0; i != 2 * BLOCK_ROWS + 1; ++i) {
+        tup.set(0, int32_t(i));
+        W.append(tup);
+    }
+    auto &zones = store.zone_map();
+    REQUIRE(zones.num_blocks() == 2);
+
+    /* Dropping back to a block boundary keeps both zones.  The next row starts the third block, which is not sealed
+     * before its rows are written. */
+    store.drop();
+    W.append(tup);
+    CHECK(zones.num_blocks() == 2);
+
+    for (std::size_t i = 2 * BLOCK_ROWS + 1; i != 3 * BLOCK_ROWS + 1; ++i) {
+        tup.set(0, int32_t(i));
+        W.append(tup);
+    }
+    REQUIRE(zones.num_blocks() == 3);
+    CHECK(zones.zones_of(0)[2].min_i == int64_t(2 * BLOCK_ROWS));
+    CHECK(zones.zones_of(0)[2].max_i == int64_t(3 * BLOCK_ROWS - 1));
+}
+
+TEST_CASE("ColumnStore/snapshots", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+
+    auto write = [&](std::size_t n, int32_t tag) {
+        auto range = store.append(n);
+        for (std::size_t i = 0; i != n; ++i) {
+            range.set(0, i, int32_t(range.first + i) + tag);
+            range.set(1, i, (range.first + i) % 3 == 0);
+            range.set_null(0, i, false);
+            range.set_null(1, i, (range.first + i) % 5 == 0);
+        }
+    };
+
+    /* Rows are visible to snapshots once the next rows are appended or they are published. */
+    write(10000, 0);
+    CHECK(store.snapshot().num_rows() == 0);
+    store.publish();
+    auto snapshot = store.snapshot();
+    REQUIRE(snapshot.num_rows() == 10000);
+
+    /* Dropping pinned rows and appending others in their place does not change the snapshot. */
+    write(5000, 0);
+    for (std::size_t i = 0; i != 7000; ++i)
+        store.drop();
+    write(9000, 1000000);
+    store.publish();
+    snapshot.read([&]() {
+        for (std::size_t row = 0; row != 10000; ++row) {
+            CHECK(snapshot.get<int32_t>(0, row) == int32_t(row));
+            CHECK(snapshot.get_bit(1, row) == (row % 3 == 0));
+            CHECK_FALSE(snapshot.is_null(0, row));
+            CHECK(snapshot.is_null(1, row) == (row % 5 == 0));
+        }
+    });
+
+    /* A new snapshot sees the new rows. */
+    auto latest = store.snapshot();
+    REQUIRE(latest.num_rows() == 17000);
+    latest.read([&]() {
+        CHECK(latest.get<int32_t>(0, 7999) == 7999);
+        CHECK(latest.get<int32_t>(0, 8000) == 8000 + 1000000);
+    });
+    snapshot.release();
+    CHECK(snapshot.num_rows() == 0);
+
+    /* A reader running concurrently to appends and drops sees every row it pinned as it was written. */
+    std::atomic<bool> done(false);
+    std::size_t errors = 0;
+    std::thread reader([&]() {
+        while (not done) {
+            auto s = store.snapshot();
+            s.read([&]() {
+                for (std::size_t row = 0; row != s.num_rows(); ++row) {
+                    const int32_t value = s.get<int32_t>(0, row);
+                    if (std::size_t(value >= 1000000 ? value - 1000000 : value) != row) ++errors;
+                }
+            });
+        }
+    });
+    for (std::size_t round = 0; round != 100; ++round) {
+        write(3000, round % 2 ? 1000000 : 0);
+        for (std::size_t i = 0; i != 2500; ++i)
+            store.drop();
+    }
+    done = true;
+    reader.join();
+    CHECK(errors == 0);
+    latest.release();
+}
+
+TEST_CASE("ColumnStore/sort key and indexes", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("flag"), m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    store.enable_compression();
+    store.sort_by(1);
+    store.add_index(0);
+
+    /* Every value is derived from the id, so rows can be checked wherever sorting moved them. */
+    auto size_of = [](int32_t id) { return int64_t(id) * 7919 % 100000; };
+    auto write = [&](std::size_t n) {
+        for (std::size_t written = 0; written != n; ) {
+            const std::size_t batch = std::min<std::size_t>(1000, n - written);
+            auto range = store.append(batch);
+            for (std::size_t i = 0; i != batch; ++i) {
+                const int32_t id = range.first + i;
+                range.set(0, i, id);
+                range.set(1, i, size_of(id));
+                range.set(2, i, id % 3 == 0);
+                range.set_null(0, i, false);
+                range.set_null(1, i, id % 97 == 0);
+                range.set_null(2, i, false);
+            }
+            written += batch;
+        }
+    };
+    auto get = [&](std::size_t attr, std::size_t row) {
+        auto layout = store.layouts()[attr];
+        int64_t value = 0;
+        std::memcpy(&value, layout.address(row), store.stride(attr));
+        return attr == 0 ? int64_t(int32_t(value)) : value;
+    };
+    auto is_null = [&](std::size_t attr, std::size_t row) {
+        auto layout = store.layouts().back();
+        return not ((layout.address(row)[attr / 8] >> (attr % 8)) & 1);
+    };
+    auto check_sorted = [&]() {
+        const std::size_t sealed = store.chunks(0).size() * ColumnStore::COMPRESSION_CHUNK_ROWS;
+        for (std::size_t row = 0; row != store.num_rows(); ++row) {
+            const int32_t id = get(0, row);
+            CHECK(is_null(1, row) == (id % 97 == 0));
+            if (not is_null(1, row))
+                CHECK(get(1, row) == size_of(id));
+            const bool flag = (*store.layouts()[2].address(row) >> store.layouts()[2].bit(row)) & 1;
+            CHECK(flag == (id % 3 == 0));
+            /* Within a sealed chunk, sizes ascend and NULLs come last. */
+            if (row < sealed && row % ColumnStore::COMPRESSION_CHUNK_ROWS != 0) {
+                if (is_null(1, row - 1))
+                    CHECK(is_null(1, row));
+                else if (not is_null(1, row))
+                    CHECK(get(1, row - 1) <= get(1, row));
+            }
+        }
+    };
+    auto check_range = [&](std::size_t attr, int64_t lower, int64_t upper) {
+        std::vector<std::size_t> found, expected;
+        store.in_range(attr, lower, upper, [&](std::size_t row) { found.push_back(row); });
+        for (std::size_t row = 0; row != store.num_rows(); ++row) {
+            if (not is_null(attr, row) && get(attr, row) >= lower && get(attr, row) < upper)
+                expected.push_back(row);
+        }
+        std::sort(found.begin(), found.end());
+        CHECK(found == expected);
+    };
+
+    /* Rows are sorted when their chunk is sealed, and only sorted rows are visible to snapshots. */
+    const std::size_t num_rows = 2 * ColumnStore::COMPRESSION_CHUNK_ROWS + 5000;
+    write(num_rows);
+    REQUIRE(store.num_rows() == num_rows);
+    REQUIRE(store.chunks(0).size() == 2);
+    check_sorted();
+    store.publish();
+    CHECK(store.snapshot().num_rows() == 2 * ColumnStore::COMPRESSION_CHUNK_ROWS);
+
+    /* Range predicates on the sort key and on the indexed column. */
+    CHECK(store.index(0, 0).size() == ColumnStore::COMPRESSION_CHUNK_ROWS);
+    CHECK(store.index(0, 1).size() == ColumnStore::COMPRESSION_CHUNK_ROWS);
+    check_range(1, 1000, 5000);
+    check_range(1, 99990, 200000);
+    check_range(0, 100, 70000);
+    check_range(0, 131000, 140000);
+
+    /* Dropping rows of a sealed chunk removes its largest sizes, the chunk is sorted again once it fills up. */
+    for (std::size_t i = 0; i != 5010; ++i)
+        store.drop();
+    REQUIRE(store.chunks(0).size() == 1);
+    check_sorted();
+    check_range(1, 1000, 5000);
+    check_range(0, 100, 70000);
+    write(20000);
+    REQUIRE(store.chunks(0).size() == 2);
+    check_sorted();
+    check_range(1, 1000, 5000);
+    check_range(0, 100, 70000);
+}
+
+TEST_CASE("ColumnStore/indexes per chunk", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.store(std::make_unique<ColumnStore>(table));
+    auto &store = static_cast<ColumnStore&>(table.store());
+    store.add_index(1);
+
+    /* The sizes of the rows that are not NULL, by row. */
+    std::vector<std::pair<std::size_t, int64_t>> sizes;
+    auto write = [&](std::size_t n, int64_t factor) {
+        auto range = store.append(n);
+        for (std::size_t i = 0; i != n; ++i) {
+            const int32_t id = range.first + i;
+            range.set(0, i, id);
+            range.set(1, i, int64_t(id) * factor % 10000);
+            range.set_null(0, i, false);
+            range.set_null(1, i, id % 13 == 0);
+            if (id % 13 != 0)
+                sizes.emplace_back(id, int64_t(id) * factor % 10000);
+        }
+    };
+    auto query = [&](int64_t lower, int64_t upper) {
+        std::vector<int64_t> found;
+        store.in_range(1, lower, upper, [&](std::size_t row) {
+            int64_t size;
+            std::memcpy(&size, store.layouts()[1].address(row), sizeof(size));
+            found.push_back(size);
+        });
+        std::sort(found.begin(), found.end());
+        return found;
+    };
+    auto expected = [&](int64_t lower, int64_t upper) {
+        std::vector<int64_t> result;
+        for (auto &size : sizes) {
+            if (size.second >= lower && size.second < upper)
+                result.push_back(size.second);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+    auto indexed = [&](std::size_t chunk) {
+        return std::count_if(sizes.begin(), sizes.end(), [chunk](auto &size) {
+            return size.first / ColumnStore::COMPRESSION_CHUNK_ROWS == chunk;
+        });
+    };
+
+    /* Each sealed chunk has a tree of its own, the rows of the delta after them are filtered. */
+    write(2 * ColumnStore::COMPRESSION_CHUNK_ROWS + 11004, 7919);
+    store.merge(); // seals both chunks
+    CHECK(store.index(1, 0).size() == std::size_t(indexed(0)));
+    CHECK(store.index(1, 1).size() == std::size_t(indexed(1)));
+    CHECK(query(1000, 5000) == expected(1000, 5000));
+    CHECK(query(0, 10000) == expected(0, 10000));
+
+    /* Dropping a row of a sealed chunk moves it back to the delta, a row appended in its place is filtered with its
+     * own value until the chunk is sealed again. */
+    while (store.num_rows() != 2 * ColumnStore::COMPRESSION_CHUNK_ROWS - 1) {
+        store.drop();
+        if (not sizes.empty() && sizes.back().first >= store.num_rows())
+            sizes.pop_back();
+    }
+    write(1, 1);
+    CHECK(query(0, 10000) == expected(0, 10000));
+    write(1000, 7919);
+    store.merge();
+    CHECK(store.index(1, 1).size() == std::size_t(indexed(1)));
+    CHECK(query(1000, 5000) == expected(1000, 5000));
+
+    /* Concurrent queries share the trees of the sealed chunks. */
+    std::vector<std::vector<int64_t>> found(4);
+    std::vector<std::thread> threads;
+    for (auto &result : found)
+        threads.emplace_back([&]() { result = query(0, 10000); });
+    for (auto &thread : threads)
+        thread.join();
+    for (auto &result : found)
+        CHECK(result == expected(0, 10000));
+}
+
+TEST_CASE("ColumnStore/background merge", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+
+    /* A store that merges chunks on append and one that merges them in the background. */
+    ColumnStore eager(table), background(table);
+    eager.enable_compression();
+    background.enable_compression();
+    eager.sort_by(1);
+    background.sort_by(1);
+    background.merge_in_background();
+
+    auto write = [&](ColumnStore &store, std::size_t n) {
+        for (std::size_t written = 0; written != n; ) {
+            const std::size_t batch = std::min<std::size_t>(1000, n - written);
+            auto range = store.append(batch);
+            for (std::size_t i = 0; i != batch; ++i) {
+                const int32_t id = range.first + i;
+                range.set(0, i, id);
+                range.set(1, i, int64_t(id) * 7919 % 100000);
+                range.set_null(0, i, false);
+                range.set_null(1, i, false);
+            }
+            written += batch;
+        }
+    };
+    auto count_rows = [](const ColumnStore &store) {
+        std::size_t num_rows = 0;
+        store.scan(0, [&](const char*, std::size_t n) { num_rows += n; });
+        return num_rows;
+    };
+
+    /* Scans see the rows of the main and of the delta while chunks are merged. */
+    const std::size_t num_rows = 3 * ColumnStore::COMPRESSION_CHUNK_ROWS + 1234;
+    for (std::size_t written = 0; written != num_rows; ) {
+        const std::size_t n = std::min<std::size_t>(10000, num_rows - written);
+        write(eager, n);
+        write(background, n);
+        written += n;
+        CHECK(count_rows(background) == written);
+    }
+    background.merge();
+    REQUIRE(eager.chunks(0).size() == 3);
+    REQUIRE(background.chunks(0).size() == 3);
+
+    /* Both stores hold the same rows in the same order. */
+    auto same_rows = [&]() {
+        REQUIRE(eager.num_rows() == background.num_rows());
+        auto expected = eager.layouts(), actual = background.layouts();
+        for (std::size_t attr = 0; attr != 2; ++attr) {
+            CHECK(std::memcmp(expected[attr].base, actual[attr].base, eager.num_rows() * eager.stride(attr)) == 0);
+        }
+        CHECK(eager.compressed_size_in_bytes() == background.compressed_size_in_bytes());
+        std::vector<std::size_t> expected_rows, actual_rows;
+        eager.in_range(1, 1000, 5000, [&](std::size_t row) { expected_rows.push_back(row); });
+        background.in_range(1, 1000, 5000, [&](std::size_t row) { actual_rows.push_back(row); });
+        CHECK(expected_rows == actual_rows);
+    };
+    same_rows();
+
+    /* Dropping rows of the main moves their chunk back to the delta, until it is merged again. */
+    for (std::size_t i = 0; i != 2000; ++i) {
+        eager.drop();
+        background.drop();
+    }
+    CHECK(background.chunks(0).size() == 2);
+    write(eager, 5000);
+    write(background, 5000);
+    background.merge();
+    CHECK(background.chunks(0).size() == 3);
+    same_rows();
 }
 
 TEST_CASE("ColumnStore/access", "[milestone1]")
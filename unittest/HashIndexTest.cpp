@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+
+#define HASH_SECTION(KEY_TYPE, VALUE_TYPE) \
+    DYNAMIC_SECTION(#KEY_TYPE "  -->  " #VALUE_TYPE)
+
+
+namespace {
+
+template<typename key_type, typename value_type>
+void __test_point_lookup()
+{
+    using index_type = HashIndex<key_type, value_type>;
+
+    SECTION("empty")
+    {
+        std::array<typename index_type::value_type, 0> data;
+        auto index = index_type::Bulkload(data);
+
+        CHECK(index.size() == 0);
+        CHECK(index.find(42) == index.end());
+    }
+
+    SECTION("one")
+    {
+        std::array<typename index_type::value_type, 1> data = { {
+            { 42, 13 },
+        } };
+        auto index = index_type::Bulkload(data);
+
+        {
+            auto it = index.find(42);
+            REQUIRE(it != index.end());
+            CHECK(it->first == 42);
+            CHECK(it->second == 13);
+        }
+        CHECK(index.find(0) == index.end());
+        CHECK(index.find(137) == index.end());
+    }
+
+    SECTION("consecutive")
+    {
+        std::vector<typename index_type::value_type> data;
+        for (key_type i = 0; i != 100; ++i) {
+            data.emplace_back(i, i*i);
+        }
+        auto index = index_type::Bulkload(data);
+        CHECK(index.capacity() * 7 / 8 >= 100);
+
+        for (key_type i = 0; i != 100; ++i) {
+            auto it = index.find(i);
+            REQUIRE(it != index.end());
+            CHECK(it->first == i);
+            CHECK(it->second == i*i);
+        }
+        CHECK(index.find(-1) == index.end());
+        CHECK(index.find(100) == index.end());
+    }
+
+    SECTION("random with duplicates")
+    {
+        std::mt19937 g(42);
+        std::uniform_int_distribution<key_type> dist_key(-100000, 100000);
+        std::vector<key_type> keys;
+        for (std::size_t i = 0; i != 10000; ++i)
+            keys.push_back(dist_key(g));
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<typename index_type::value_type> data;
+        for (std::size_t i = 0; i != keys.size(); ++i)
+            data.emplace_back(keys[i], value_type(i));
+        auto index = index_type::Bulkload(data);
+
+        for (std::size_t i = 0; i != 10000; ++i) {
+            const key_type k = dist_key(g);
+            auto pos = std::lower_bound(keys.begin(), keys.end(), k);
+            auto it = index.find(k);
+            if (pos != keys.end() and *pos == k) {
+                REQUIRE(it != index.end());
+                CHECK(it->first == k);
+                /* `find` must return the first of all entries with that key */
+                CHECK(std::size_t(it->second) == std::size_t(pos - keys.begin()));
+            } else {
+                CHECK(it == index.end());
+            }
+        }
+    }
+}
+
+}
+
+
+TEST_CASE("HashIndex/point lookup", "[milestone2]")
+{
+#define TEST(KEY_TYPE, VALUE_TYPE) \
+    HASH_SECTION(KEY_TYPE, VALUE_TYPE) { __test_point_lookup<KEY_TYPE, VALUE_TYPE>(); }
+
+    TEST(int32_t, int32_t);
+    TEST(int32_t, int64_t);
+    TEST(int64_t, int32_t);
+    TEST(int64_t, int64_t);
+
+#undef TEST
+}
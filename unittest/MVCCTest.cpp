@@ -0,0 +1,227 @@
+#include "catch.hpp"
+
+#include "MVCC.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutable/mutable.hpp>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+/* Creates a table of accounts with an id, a balance, and a flag, backed by a `RowStore`. */
+RowStore & create_accounts(std::size_t num_rows)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("accounts"));
+    table.push_back(C.pool("id"),      m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("balance"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.push_back(C.pool("active"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("name"),    m::Type::Get_Char(m::Type::TY_Vector, 6));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = static_cast<RowStore&>(table.store());
+    auto range = store.append(num_rows);
+    for (std::size_t i = 0; i != num_rows; ++i) {
+        range.set(0, i, int32_t(i));
+        range.set(1, i, int64_t(100));
+        range.set(2, i, true);
+        range.set(3, i, "abc", 3, 6);
+        for (std::size_t attr = 0; attr != 4; ++attr)
+            range.set_null(attr, i, false);
+    }
+    return store;
+}
+
+}
+
+TEST_CASE("MVCC/visibility", "[milestone1]")
+{
+    auto &store = create_accounts(10);
+    MVCC mvcc(store);
+    std::vector<char> image(mvcc.row_bytes());
+
+    auto &reader = mvcc.begin();
+    auto &writer = mvcc.begin();
+    REQUIRE(mvcc.update(writer, 3, 1, int64_t(42)));
+    REQUIRE(mvcc.update(writer, 3, 2, false));
+    REQUIRE(mvcc.update(writer, 3, 3, "xyz"));
+    REQUIRE(mvcc.set_null(writer, 4, 1));
+    auto range = mvcc.insert(writer);
+    range.set(0, 0, int32_t(10));
+    range.set(1, 0, int64_t(7));
+    range.set(2, 0, false);
+    range.set(3, 0, "new", 3, 6);
+    for (std::size_t attr = 0; attr != 4; ++attr)
+        range.set_null(attr, 0, false);
+    CHECK(store.num_rows() == 11);
+
+    /* The writer sees its own changes, other transactions do not. */
+    REQUIRE(mvcc.read(writer, 3, image.data()));
+    CHECK(mvcc.get<int64_t>(image.data(), 1) == 42);
+    CHECK_FALSE(mvcc.get_bit(image.data(), 2));
+    CHECK(std::strncmp(image.data() + store.layouts()[3].offset / 8, "xyz", 6) == 0);
+    REQUIRE(mvcc.read(writer, 4, image.data()));
+    CHECK(mvcc.is_null(image.data(), 1));
+    CHECK(mvcc.read(writer, 10, image.data()));
+
+    REQUIRE(mvcc.read(reader, 3, image.data()));
+    CHECK(mvcc.get<int64_t>(image.data(), 1) == 100);
+    CHECK(mvcc.get_bit(image.data(), 2));
+    CHECK(std::strncmp(image.data() + store.layouts()[3].offset / 8, "abc", 6) == 0);
+    REQUIRE(mvcc.read(reader, 4, image.data()));
+    CHECK_FALSE(mvcc.is_null(image.data(), 1));
+    CHECK_FALSE(mvcc.read(reader, 10, image.data()));
+
+    /* After the commit, only transactions that begin afterwards see the changes. */
+    mvcc.commit(writer);
+    std::size_t num_rows = 0;
+    int64_t sum = 0;
+    mvcc.scan(reader, [&](std::size_t, const char *row) { ++num_rows; sum += mvcc.get<int64_t>(row, 1); });
+    CHECK(num_rows == 10);
+    CHECK(sum == 1000);
+
+    auto &later = mvcc.begin();
+    num_rows = 0;
+    sum = 0;
+    mvcc.scan(later, [&](std::size_t, const char *row) {
+        ++num_rows;
+        if (not mvcc.is_null(row, 1)) sum += mvcc.get<int64_t>(row, 1);
+    });
+    CHECK(num_rows == 11);
+    CHECK(sum == 800 + 42 + 7);
+    mvcc.commit(later);
+    mvcc.commit(reader);
+
+    /* Without active transactions, no deltas are retained. */
+    CHECK(mvcc.num_retained() == 0);
+    auto &last = mvcc.begin();
+    REQUIRE(mvcc.read(last, 3, image.data()));
+    CHECK(mvcc.get<int64_t>(image.data(), 1) == 42);
+    mvcc.commit(last);
+}
+
+TEST_CASE("MVCC/conflicts", "[milestone1]")
+{
+    auto &store = create_accounts(10);
+    MVCC mvcc(store);
+    std::vector<char> image(mvcc.row_bytes());
+
+    /* The first updater of a row wins, the second must abort. */
+    auto &first = mvcc.begin();
+    auto &second = mvcc.begin();
+    REQUIRE(mvcc.update(first, 5, 1, int64_t(1)));
+    CHECK_FALSE(mvcc.update(second, 5, 1, int64_t(2)));
+    CHECK(mvcc.update(second, 6, 1, int64_t(2)));
+    mvcc.commit(first);
+    CHECK_FALSE(mvcc.update(second, 5, 1, int64_t(2))); // committed after `second` began
+    mvcc.abort(second);
+
+    /* Aborting restores the rows and hides inserted rows. */
+    auto &aborted = mvcc.begin();
+    REQUIRE(mvcc.update(aborted, 7, 1, int64_t(3)));
+    mvcc.insert(aborted);
+    mvcc.abort(aborted);
+
+    auto &reader = mvcc.begin();
+    REQUIRE(mvcc.read(reader, 5, image.data()));
+    CHECK(mvcc.get<int64_t>(image.data(), 1) == 1);
+    REQUIRE(mvcc.read(reader, 6, image.data()));
+    CHECK(mvcc.get<int64_t>(image.data(), 1) == 100);
+    REQUIRE(mvcc.read(reader, 7, image.data()));
+    CHECK(mvcc.get<int64_t>(image.data(), 1) == 100);
+    CHECK_FALSE(mvcc.read(reader, 10, image.data()));
+    CHECK(mvcc.update(reader, 7, 1, int64_t(4)));
+    CHECK_FALSE(mvcc.update(reader, 10, 1, int64_t(4)));
+    mvcc.commit(reader);
+}
+
+TEST_CASE("MVCC/zone maps and snapshots", "[milestone1]")
+{
+    const std::size_t BLOCK_ROWS = ZoneMap::DEFAULT_BLOCK_ROWS;
+    auto &store = create_accounts(2 * BLOCK_ROWS);
+    MVCC mvcc(store);
+
+    /* Inserting a row seals both blocks, whose balances are all 100. */
+    auto &inserter = mvcc.begin();
+    auto range = mvcc.insert(inserter);
+    range.set(1, 0, int64_t(100));
+    for (std::size_t attr = 0; attr != 4; ++attr)
+        range.set_null(attr, 0, false);
+    mvcc.commit(inserter);
+    REQUIRE(store.zone_map().num_blocks() == 2);
+
+    auto snapshot = store.snapshot();
+    REQUIRE(snapshot.num_rows() == 2 * BLOCK_ROWS);
+    auto &writer = mvcc.begin();
+    REQUIRE(mvcc.update(writer, 5, 1, int64_t(1000)));
+    REQUIRE(mvcc.set_null(writer, 6, 1));
+    mvcc.commit(writer);
+
+    /* A zone map scan for the new balance visits the first block, but still skips the second. */
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    store.zone_map().scan(1, int64_t(1000), int64_t(1000), store.num_rows(),
+                          [&](std::size_t first, std::size_t n) { runs.emplace_back(first, n); });
+    REQUIRE(runs.size() == 2);
+    CHECK(runs[0] == std::make_pair(std::size_t(0), BLOCK_ROWS));
+    CHECK(runs[1] == std::make_pair(2 * BLOCK_ROWS, std::size_t(1)));
+
+    /* The snapshot pinned before the update still sees the old values, a new one sees the update. */
+    snapshot.read([&]() {
+        CHECK(snapshot.get<int64_t>(1, 5) == 100);
+        CHECK_FALSE(snapshot.is_null(1, 6));
+        CHECK(snapshot.get<int64_t>(1, 6) == 100);
+        CHECK(snapshot.get<int64_t>(1, BLOCK_ROWS) == 100);
+    });
+    snapshot.release();
+    auto later = store.snapshot();
+    later.read([&]() {
+        CHECK(later.get<int64_t>(1, 5) == 1000);
+        CHECK(later.is_null(1, 6));
+    });
+}
+
+TEST_CASE("MVCC/concurrent scans", "[milestone1]")
+{
+    constexpr std::size_t NUM_ROWS = 1000;
+    auto &store = create_accounts(NUM_ROWS);
+    MVCC mvcc(store);
+
+    /* Transfers between accounts keep the total balance, which every snapshot must see. */
+    std::atomic<bool> done(false);
+    std::size_t num_scans = 0, errors = 0;
+    std::thread reader([&]() {
+        while (not done) {
+            auto &txn = mvcc.begin();
+            int64_t sum = 0;
+            mvcc.scan(txn, [&](std::size_t, const char *row) { sum += mvcc.get<int64_t>(row, 1); });
+            mvcc.commit(txn);
+            if (sum != int64_t(100 * NUM_ROWS)) ++errors;
+            ++num_scans;
+        }
+    });
+
+    std::vector<char> image(mvcc.row_bytes());
+    for (std::size_t i = 0; i != 20000; ++i) {
+        auto &txn = mvcc.begin();
+        const std::size_t from = i * 7 % NUM_ROWS, to = i * 13 % NUM_ROWS;
+        if (from == to) {
+            mvcc.commit(txn);
+            continue;
+        }
+        REQUIRE(mvcc.read(txn, from, image.data()));
+        const int64_t from_balance = mvcc.get<int64_t>(image.data(), 1);
+        REQUIRE(mvcc.read(txn, to, image.data()));
+        const int64_t to_balance = mvcc.get<int64_t>(image.data(), 1);
+        REQUIRE(mvcc.update(txn, from, 1, from_balance - 5));
+        REQUIRE(mvcc.update(txn, to, 1, to_balance + 5));
+        mvcc.commit(txn);
+    }
+    done = true;
+    reader.join();
+    CHECK(num_scans > 0);
+    CHECK(errors == 0);
+}
@@ -0,0 +1,158 @@
+#include "catch.hpp"
+
+#include "PaxStore.hpp"
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <utility>
+
+
+TEST_CASE("PaxStore/c'tor", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<PaxStore>(table));
+    auto &lin = table.store().linearization();
+
+    /* Root must be an infinite sequence of pages. */
+    CHECK(lin.num_tuples() == 0); // infinite sequence
+    REQUIRE(lin.num_sequences() == 1); // of pages
+
+    const auto &seq_page = *lin.begin();
+    REQUIRE(seq_page.is_linearization());
+    CHECK(seq_page.offset != 0); // address of first page
+    CHECK(seq_page.stride == PaxStore::PAGE_SIZE);
+
+    /* A page holds a finite number of rows, with one minipage per attribute and one for the null bitmap. */
+    const auto &page = seq_page.as_linearization();
+    CHECK(page.num_tuples() > 1);
+    REQUIRE(page.num_sequences() == 3);
+
+    auto page_it = page.begin();
+    const auto &seq_a = *page_it;
+    REQUIRE(seq_a.is_attribute());
+    CHECK(seq_a.offset == 0); // minipage of 'a' starts the page
+    CHECK(seq_a.stride == 32); // 4 byte INT
+
+    const auto &seq_b = *++page_it;
+    REQUIRE(seq_b.is_attribute());
+    CHECK(seq_b.offset == 32 * page.num_tuples()); // minipage of 'b' follows minipage of 'a'
+    CHECK(seq_b.stride == 1); // booleans are bit-packed
+
+    const auto &null_bitmap = *++page_it;
+    REQUIRE(null_bitmap.is_null_bitmap());
+    CHECK(null_bitmap.stride == 2); // 2 attributes
+    CHECK(null_bitmap.offset + 2 * page.num_tuples() <= 8 * PaxStore::PAGE_SIZE); // minipages fit into the page
+}
+
+TEST_CASE("PaxStore/access", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+
+    const std::pair<const char*, const m::PrimitiveType*> Attributes[] = {
+        { "a_i4",   m::Type::Get_Integer(m::Type::TY_Vector, 4) },
+        { "b_f",    m::Type::Get_Float(m::Type::TY_Vector) },
+        { "c_i2",   m::Type::Get_Integer(m::Type::TY_Vector, 2) },
+        { "d_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+        { "e_d",    m::Type::Get_Double(m::Type::TY_Vector) },
+        { "f_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+        { "g_c",    m::Type::Get_Char(m::Type::TY_Vector, 7) },
+        { "h_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+        { "i_b",    m::Type::Get_Boolean(m::Type::TY_Vector) },
+    };
+    for (auto &attr : Attributes)
+        table.push_back(C.pool(attr.first), attr.second);
+
+    /* Create and set store. */
+    table.store(std::make_unique<PaxStore>(table));
+
+    /* Process queries. */
+    C.set_database_in_use(DB);
+
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+
+    {
+        auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+
+        std::size_t num_tuples = 0;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple&) {
+            ++num_tuples;
+        });
+
+        std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+        m::execute_query(diag, *select_stmt, std::move(callback));
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+        REQUIRE(num_tuples == 0);
+    }
+
+    {
+        auto insertions = m::statement_from_string(diag, "INSERT INTO test VALUES \
+                ( 42, 3.14, 1337, TRUE, 2.71828, FALSE, \"female\", TRUE, NULL ), \
+                ( NULL, 6.62607015, -137, NULL, 6.241509074, FALSE, NULL, TRUE, FALSE );");
+        m::execute_statement(diag, *insertions);
+
+        auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+
+#define IDX(ATTR) S[C.pool(ATTR)].first
+#define CHECK_VALUE(ATTR, TYPE, VALUE) \
+    REQUIRE_FALSE(T.is_null(IDX(ATTR))); \
+    CHECK((VALUE) == T.get(IDX(ATTR)).as_##TYPE())
+#define CHECK_CHAR(ATTR, VALUE) \
+    REQUIRE_FALSE(T.is_null(IDX(ATTR))); \
+    CHECK(std::string(VALUE) == reinterpret_cast<char*>(T.get(IDX(ATTR)).as_p()))
+
+        std::size_t num_tuples = 0;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+            switch (num_tuples) {
+                case 0: {
+                    CHECK_VALUE("a_i4", i, 42);
+                    CHECK_VALUE("b_f",  f, 3.14f);
+                    CHECK_VALUE("c_i2", i, 1337);
+                    CHECK_VALUE("d_b",  b, true);
+                    CHECK_VALUE("e_d",  d, 2.71828);
+                    CHECK_VALUE("f_b",  b, false);
+                    CHECK_VALUE("h_b",  b, true);
+                    CHECK_CHAR("g_c", "female");
+                    CHECK(T.is_null(IDX("i_b")));
+                    break;
+                }
+
+                case 1: {
+                    CHECK(T.is_null(IDX("a_i4")));
+                    CHECK_VALUE("b_f",  f, 6.62607015f);
+                    CHECK_VALUE("c_i2", i, -137);
+                    CHECK(T.is_null(IDX("d_b")));
+                    CHECK_VALUE("e_d",  d, 6.241509074);
+                    CHECK_VALUE("f_b",  b, false);
+                    CHECK(T.is_null(IDX("g_c")));
+                    CHECK_VALUE("h_b",  b, true);
+                    CHECK_VALUE("i_b", b, false);
+                    break;
+                }
+
+                default:
+                    REQUIRE(false);
+            }
+            ++num_tuples;
+        });
+
+        std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+        m::execute_query(diag, *select_stmt, std::move(callback));
+        REQUIRE(diag.num_errors() == 0);
+        REQUIRE(err.str().empty());
+        REQUIRE(num_tuples == 2);
+    }
+}
@@ -1,9 +1,14 @@
 #include "catch.hpp"
 
 #include "RowStore.hpp"
+#include <atomic>
+#include <cstdio>
 #include <mutable/mutable.hpp>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 
 TEST_CASE("RowStore/c'tor", "[milestone1]")
@@ -294,6 +299,376 @@ TEST_CASE("RowStore/c'tor", "[milestone1]")
             CHECK(null_bitmap.stride == 0); // there is no stride within a row
         }
     }
+
+    SECTION("reordered attributes")
+    {
+        table.push_back(C.pool("a"), m::Type::Get_Boolean(m::Type::TY_Vector));
+        table.push_back(C.pool("b"), m::Type::Get_Double(m::Type::TY_Vector));
+        table.push_back(C.pool("c"), m::Type::Get_Boolean(m::Type::TY_Vector));
+        table.push_back(C.pool("d"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        table.store(std::make_unique<RowStore>(table));
+
+        auto &lin = table.store().linearization();
+        const auto &seq_row = *lin.begin();
+        REQUIRE(seq_row.is_linearization());
+        CHECK(seq_row.stride == 16); // 8 byte DOUBLE, 4 byte INT, 2 bit BOOL, 4 bit null bitmap, padding
+
+        /* Attributes are placed by decreasing alignment, but remain in the order of the table. */
+        const auto &row = seq_row.as_linearization();
+        REQUIRE(row.num_sequences() == 5); // four attributes and null bitmap
+        const uint64_t Offsets[] = { 96, 0, 97, 64 };
+        auto row_it = row.begin();
+        for (std::size_t i = 0; i != 4; ++i, ++row_it) {
+            REQUIRE(row_it->is_attribute());
+            CHECK(row_it->as_attribute().id == i);
+            CHECK(row_it->offset == Offsets[i]);
+        }
+        REQUIRE(row_it->is_null_bitmap());
+        CHECK(row_it->offset == 98); // null bitmap located after the packed booleans
+    }
+}
+
+TEST_CASE("RowStore/append", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = table.store();
+    const auto row_address = (*store.linearization().begin()).offset;
+
+    /* Grow the store across many blocks; rows must never move. */
+    for (std::size_t i = 0; i != 100000; ++i)
+        store.append();
+    CHECK(store.num_rows() == 100000);
+    CHECK((*store.linearization().begin()).offset == row_address);
+
+    store.drop();
+    CHECK(store.num_rows() == 99999);
+}
+
+TEST_CASE("RowStore/shrink", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b"), m::Type::Get_Char(m::Type::TY_Vector, 32));
+    table.store(std::make_unique<RowStore>(table));
+    auto &store = static_cast<RowStore&>(table.store());
+    const uint64_t address = store.linearization().begin()->offset;
+
+    for (std::size_t i = 0; i != 100000; ++i)
+        store.append();
+    const std::size_t peak = store.allocated_rows();
+    REQUIRE(peak >= 100000);
+
+    /* Dropping most rows releases memory. */
+    while (store.num_rows() != 1000)
+        store.drop();
+    const std::size_t shrunk = store.allocated_rows();
+    CHECK(shrunk < peak / 2);
+    CHECK(shrunk >= 1000);
+
+    /* Alternating appends and drops around the new size neither grow nor shrink the store. */
+    for (std::size_t i = 0; i != 100; ++i) {
+        store.append();
+        store.drop();
+    }
+    CHECK(store.allocated_rows() == shrunk);
+
+    /* Released memory is committed again on demand, at the same address. */
+    for (std::size_t i = 0; i != 99000; ++i)
+        store.append();
+    CHECK(store.num_rows() == 100000);
+    CHECK(store.allocated_rows() >= 100000);
+    CHECK(store.linearization().begin()->offset == address);
+}
+
+TEST_CASE("RowStore/bulk append", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = static_cast<RowStore&>(table.store());
+    store.reserve(1000);
+
+    /* Append in batches of different sizes. */
+    std::size_t num_rows = 0;
+    for (std::size_t n : { 1, 99, 900 }) {
+        auto range = store.append(n);
+        CHECK(range.first == num_rows);
+        CHECK(range.num_rows == n);
+        for (std::size_t i = 0; i != n; ++i, ++num_rows) {
+            range.set(0, i, int32_t(num_rows));
+            range.set(1, i, num_rows % 2 == 0);
+            range.set(2, i, "abc", 3, 5);
+            range.set_null(0, i, false);
+            range.set_null(1, i, num_rows % 7 == 0);
+            range.set_null(2, i, false);
+        }
+    }
+    REQUIRE(store.num_rows() == 1000);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+        CHECK(T.get(S[C.pool("a_i4")].first).as_i() == int64_t(num_tuples));
+        if (num_tuples % 7 == 0)
+            CHECK(T.is_null(S[C.pool("b_b")].first));
+        else
+            CHECK(T.get(S[C.pool("b_b")].first).as_b() == (num_tuples % 2 == 0));
+        CHECK(std::string("abc") == reinterpret_cast<char*>(T.get(S[C.pool("c_c5")].first).as_p()));
+        ++num_tuples;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == 1000);
+}
+
+TEST_CASE("RowStore/persistent", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+
+    const std::string filename = std::string(P_tmpdir) + "/RowStoreTest.store";
+    std::remove(filename.c_str());
+
+    {
+        /* Fill a new file. */
+        auto store = std::make_unique<RowStore>(table, filename.c_str());
+        REQUIRE(store->is_persistent());
+        REQUIRE(store->num_rows() == 0);
+        auto range = store->append(1000);
+        for (std::size_t i = 0; i != 1000; ++i) {
+            range.set(0, i, int32_t(i));
+            range.set(1, i, i % 2 == 0);
+            range.set(2, i, "abc", 3, 5);
+            range.set_null(0, i, false);
+            range.set_null(1, i, i % 7 == 0);
+            range.set_null(2, i, false);
+        }
+        store->drop();
+        store->sync();
+    }
+
+    /* Reopening the file restores all rows. */
+    table.store(std::make_unique<RowStore>(table, filename.c_str()));
+    REQUIRE(table.store().num_rows() == 999);
+
+    C.set_database_in_use(DB);
+    std::ostringstream out, err;
+    m::Diagnostic diag(false, out, err);
+    auto stmt = m::statement_from_string(diag, "SELECT * FROM test;");
+    REQUIRE(diag.num_errors() == 0);
+
+    std::size_t num_tuples = 0;
+    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &T) {
+        CHECK(T.get(S[C.pool("a_i4")].first).as_i() == int64_t(num_tuples));
+        if (num_tuples % 7 == 0)
+            CHECK(T.is_null(S[C.pool("b_b")].first));
+        else
+            CHECK(T.get(S[C.pool("b_b")].first).as_b() == (num_tuples % 2 == 0));
+        CHECK(std::string("abc") == reinterpret_cast<char*>(T.get(S[C.pool("c_c5")].first).as_p()));
+        ++num_tuples;
+    });
+
+    std::unique_ptr<m::SelectStmt> select_stmt(static_cast<m::SelectStmt*>(stmt.release()));
+    m::execute_query(diag, *select_stmt, std::move(callback));
+    REQUIRE(diag.num_errors() == 0);
+    CHECK(num_tuples == 999);
+
+    /* Appending continues after the restored rows. */
+    table.store().append();
+    CHECK(table.store().num_rows() == 1000);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("RowStore/zone maps", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"),   m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("size"), m::Type::Get_Double(m::Type::TY_Vector));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = static_cast<RowStore&>(table.store());
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+
+    /* Fill three blocks and a few rows of a fourth block, which is not sealed. */
+    const std::size_t BLOCK_ROWS = store.zone_map().block_rows();
+    const std::size_t num_rows = 3 * BLOCK_ROWS + 100;
+    for (std::size_t i = 0; i != num_rows; ++i) {
+        tup.set(0, int32_t(i));
+        tup.set(1, double(num_rows - i) / 2);
+        W.append(tup);
+    }
+
+    auto &zones = store.zone_map();
+    REQUIRE(zones.num_blocks() == 3);
+    for (std::size_t b = 0; b != 3; ++b) {
+        const Zone &id = zones.zones_of(0)[b];
+        CHECK(id.num_nulls == 0);
+        CHECK(id.min_i == int64_t(b * BLOCK_ROWS));
+        CHECK(id.max_i == int64_t((b + 1) * BLOCK_ROWS - 1));
+        const Zone &size = zones.zones_of(1)[b];
+        CHECK(size.min_d == double(num_rows - (b + 1) * BLOCK_ROWS + 1) / 2);
+        CHECK(size.max_d == double(num_rows - b * BLOCK_ROWS) / 2);
+    }
+
+    /* A scan for a range inside the second block skips the first and third block, but visits the unsealed rows. */
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    zones.scan(0, int32_t(BLOCK_ROWS + 10), int32_t(BLOCK_ROWS + 20), store.num_rows(),
+               [&](std::size_t first, std::size_t n) { runs.emplace_back(first, n); });
+    REQUIRE(runs.size() == 2);
+    CHECK(runs[0] == std::make_pair(BLOCK_ROWS, BLOCK_ROWS));
+    CHECK(runs[1] == std::make_pair(3 * BLOCK_ROWS, std::size_t(100)));
+
+    /* Dropping a row of a sealed block discards its zone. */
+    for (std::size_t i = 0; i != 101; ++i)
+        store.drop();
+    CHECK(zones.num_blocks() == 2);
+}
+
+TEST_CASE("RowStore/zone maps after drop", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("id"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.store(std::make_unique<RowStore>(table));
+
+    auto &store = static_cast<RowStore&>(table.store());
+    m::StoreWriter W(store);
+    m::Tuple tup(W.schema());
+
+    /* Fill two blocks and one row of a third block. */
+    const std::size_t BLOCK_ROWS = store.zone_map().block_rows();
+    for (std::size_t i = 0; i != 2 * BLOCK_ROWS + 1; ++i) {
+        tup.set(0, int32_t(i));
+        W.append(tup);
+    }
+    auto &zones = store.zone_map();
+    REQUIRE(zones.num_blocks() == 2);
+
+    /* Dropping back to a block boundary keeps both zones.  The next row starts the third block, which is not sealed
+     * before its rows are written. */
+    store.drop();
+    W.append(tup);
+    CHECK(zones.num_blocks() == 2);
+
+    for (std::size_t i = 2 * BLOCK_ROWS + 1; i != 3 * BLOCK_ROWS + 1; ++i) {
+        tup.set(0, int32_t(i));
+        W.append(tup);
+    }
+    REQUIRE(zones.num_blocks() == 3);
+    CHECK(zones.zones_of(0)[2].min_i == int64_t(2 * BLOCK_ROWS));
+    CHECK(zones.zones_of(0)[2].max_i == int64_t(3 * BLOCK_ROWS - 1));
+}
+
+TEST_CASE("RowStore/snapshots", "[milestone1]")
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.store(std::make_unique<RowStore>(table));
+    auto &store = static_cast<RowStore&>(table.store());
+
+    auto write = [&](std::size_t n, int32_t tag) {
+        auto range = store.append(n);
+        for (std::size_t i = 0; i != n; ++i) {
+            range.set(0, i, int32_t(range.first + i) + tag);
+            range.set(1, i, (range.first + i) % 3 == 0);
+            range.set_null(0, i, false);
+            range.set_null(1, i, (range.first + i) % 5 == 0);
+        }
+    };
+
+    /* Rows are visible to snapshots once the next rows are appended or they are published. */
+    write(10000, 0);
+    CHECK(store.snapshot().num_rows() == 0);
+    store.publish();
+    auto snapshot = store.snapshot();
+    REQUIRE(snapshot.num_rows() == 10000);
+
+    /* Dropping pinned rows and appending others in their place does not change the snapshot. */
+    write(5000, 0);
+    for (std::size_t i = 0; i != 7000; ++i)
+        store.drop();
+    write(9000, 1000000);
+    store.publish();
+    snapshot.read([&]() {
+        for (std::size_t row = 0; row != 10000; ++row) {
+            CHECK(snapshot.get<int32_t>(0, row) == int32_t(row));
+            CHECK(snapshot.get_bit(1, row) == (row % 3 == 0));
+            CHECK_FALSE(snapshot.is_null(0, row));
+            CHECK(snapshot.is_null(1, row) == (row % 5 == 0));
+        }
+    });
+
+    /* A new snapshot sees the new rows. */
+    auto latest = store.snapshot();
+    REQUIRE(latest.num_rows() == 17000);
+    latest.read([&]() {
+        CHECK(latest.get<int32_t>(0, 7999) == 7999);
+        CHECK(latest.get<int32_t>(0, 8000) == 8000 + 1000000);
+    });
+    snapshot.release();
+    CHECK(snapshot.num_rows() == 0);
+
+    /* A reader running concurrently to appends and drops sees every row it pinned as it was written. */
+    std::atomic<bool> done(false);
+    std::size_t errors = 0;
+    std::thread reader([&]() {
+        while (not done) {
+            auto s = store.snapshot();
+            s.read([&]() {
+                for (std::size_t row = 0; row != s.num_rows(); ++row) {
+                    const int32_t value = s.get<int32_t>(0, row);
+                    if (std::size_t(value >= 1000000 ? value - 1000000 : value) != row) ++errors;
+                }
+            });
+        }
+    });
+    for (std::size_t round = 0; round != 100; ++round) {
+        write(3000, round % 2 ? 1000000 : 0);
+        for (std::size_t i = 0; i != 2500; ++i)
+            store.drop();
+    }
+    done = true;
+    reader.join();
+    CHECK(errors == 0);
+    latest.release();
 }
 
 TEST_CASE("RowStore/access", "[milestone1]")
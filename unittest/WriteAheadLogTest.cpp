@@ -0,0 +1,273 @@
+#include "catch.hpp"
+
+#include "ColumnStore.hpp"
+#include "MVCC.hpp"
+#include "RowStore.hpp"
+#include "WriteAheadLog.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutable/mutable.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+/* Creates a table with an integer, a boolean, and a character sequence attribute. */
+m::Table & create_table()
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+    return table;
+}
+
+/* Writes the values of the `row`-th row to row `i` of `range`. */
+void write_row(RowRange &range, std::size_t i, std::size_t row)
+{
+    range.set(0, i, int32_t(row));
+    range.set(1, i, row % 2 == 0);
+    range.set(2, i, "abc", 3, 5);
+    range.set_null(0, i, false);
+    range.set_null(1, i, row % 7 == 0);
+    range.set_null(2, i, false);
+}
+
+template<typename Store>
+void append_rows(Store &store, std::size_t first, std::size_t n)
+{
+    auto range = store.append(n);
+    for (std::size_t i = 0; i != n; ++i)
+        write_row(range, i, first + i);
+}
+
+template<typename Store>
+void check_rows(const Store &store, std::size_t num_rows)
+{
+    REQUIRE(store.num_rows() == num_rows);
+    auto layouts = store.layouts();
+    for (std::size_t row = 0; row != num_rows; ++row) {
+        int32_t value;
+        std::memcpy(&value, layouts[0].address(row), sizeof(value));
+        CHECK(value == int32_t(row));
+        const uint64_t null_bit = layouts.back().bit(row) + 1;
+        const bool present = (layouts.back().address(row)[null_bit / 8] >> (null_bit % 8)) & 1;
+        CHECK(present == (row % 7 != 0));
+        if (present)
+            CHECK(bool((*layouts[1].address(row) >> layouts[1].bit(row)) & 1) == (row % 2 == 0));
+        CHECK(std::strncmp(layouts[2].address(row), "abc", 5) == 0);
+    }
+}
+
+template<typename Store>
+void check_replay(const char *name)
+{
+    auto &table = create_table();
+    const std::string filename = std::string(P_tmpdir) + "/" + name;
+    std::remove(filename.c_str());
+
+    {
+        WriteAheadLog log(filename.c_str());
+        Store store(table);
+        store.attach_log(log);
+        append_rows(store, 0, 3000);
+        append_rows(store, 3000, 10);
+        store.drop();
+        store.drop();
+        store.commit();
+        append_rows(store, 3008, 5); // never committed
+    }
+
+    /* A new store recovers the committed rows; rows that were not committed may be lost. */
+    {
+        WriteAheadLog log(filename.c_str());
+        Store store(table);
+        store.attach_log(log);
+        REQUIRE(store.num_rows() >= 3008);
+        check_rows(store, 3008);
+
+        /* Logging continues after the replayed rows. */
+        append_rows(store, 3008, 2);
+        store.commit();
+    }
+    {
+        WriteAheadLog log(filename.c_str());
+        Store store(table);
+        store.attach_log(log);
+        check_rows(store, 3010);
+    }
+    std::remove(filename.c_str());
+}
+
+}
+
+TEST_CASE("WriteAheadLog/replay RowStore", "[milestone1]")
+{
+    check_replay<RowStore>("WriteAheadLogTest_row.log");
+}
+
+TEST_CASE("WriteAheadLog/replay ColumnStore", "[milestone1]")
+{
+    check_replay<ColumnStore>("WriteAheadLogTest_column.log");
+}
+
+TEST_CASE("WriteAheadLog/torn tail", "[milestone1]")
+{
+    auto &table = create_table();
+    const std::string filename = std::string(P_tmpdir) + "/WriteAheadLogTest_torn.log";
+    std::remove(filename.c_str());
+
+    {
+        WriteAheadLog log(filename.c_str());
+        RowStore store(table);
+        store.attach_log(log);
+        append_rows(store, 0, 100);
+        store.commit();
+    }
+    {
+        /* A crash in the middle of writing a record leaves part of it at the end of the file. */
+        std::ofstream out(filename, std::ios::binary | std::ios::app);
+        const char garbage[30] = { 1, 2, 3 };
+        out.write(garbage, sizeof(garbage));
+    }
+
+    /* The torn record is discarded, and records appended afterwards are replayed. */
+    {
+        WriteAheadLog log(filename.c_str());
+        RowStore store(table);
+        store.attach_log(log);
+        check_rows(store, 100);
+        append_rows(store, 100, 50);
+        store.commit();
+    }
+    {
+        WriteAheadLog log(filename.c_str());
+        RowStore store(table);
+        store.attach_log(log);
+        check_rows(store, 150);
+    }
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("WriteAheadLog/garbage header", "[milestone1]")
+{
+    auto &table = create_table();
+    const std::string filename = std::string(P_tmpdir) + "/WriteAheadLogTest_garbage.log";
+    std::remove(filename.c_str());
+
+    {
+        WriteAheadLog log(filename.c_str());
+        RowStore store(table);
+        store.attach_log(log);
+        append_rows(store, 0, 100);
+        store.commit();
+    }
+    {
+        /* A header whose payload size exceeds the file is not read any further. */
+        std::ofstream out(filename, std::ios::binary | std::ios::app);
+        WriteAheadLog::Record record{ 0, 0, WriteAheadLog::APPEND, 100, 1, ~uint64_t(0) };
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    WriteAheadLog log(filename.c_str());
+    RowStore store(table);
+    store.attach_log(log);
+    check_rows(store, 100);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("WriteAheadLog/replay MVCC", "[milestone1]")
+{
+    auto &table = create_table();
+    const std::string filename = std::string(P_tmpdir) + "/WriteAheadLogTest_mvcc.log";
+    std::remove(filename.c_str());
+
+    {
+        WriteAheadLog log(filename.c_str());
+        RowStore store(table);
+        store.attach_log(log);
+        append_rows(store, 0, 100);
+        MVCC mvcc(store);
+
+        auto &txn = mvcc.begin();
+        REQUIRE(mvcc.update(txn, 5, 0, int32_t(500)));
+        auto range = mvcc.insert(txn);
+        write_row(range, 0, 100);
+        mvcc.commit(txn);
+
+        auto &aborted = mvcc.begin();
+        REQUIRE(mvcc.update(aborted, 6, 0, int32_t(600)));
+        mvcc.insert(aborted);
+        mvcc.abort(aborted);
+
+        auto &last = mvcc.begin();
+        range = mvcc.insert(last);
+        write_row(range, 0, 102);
+        mvcc.commit(last);
+
+        auto &uncommitted = mvcc.begin();
+        REQUIRE(mvcc.update(uncommitted, 7, 0, int32_t(700)));
+    }
+
+    /* Committed updates and inserted rows are recovered, the row of the aborted transaction is NULL. */
+    WriteAheadLog log(filename.c_str());
+    RowStore store(table);
+    store.attach_log(log);
+    REQUIRE(store.num_rows() == 103);
+    auto layouts = store.layouts();
+    auto value = [&](std::size_t row) {
+        int32_t v;
+        std::memcpy(&v, layouts[0].address(row), sizeof(v));
+        return v;
+    };
+    CHECK(value(5) == 500);
+    CHECK(value(6) == 6);
+    CHECK(value(7) == 7);
+    CHECK(value(100) == 100);
+    CHECK(value(102) == 102);
+    const uint64_t null_bit = layouts.back().bit(101);
+    CHECK(((layouts.back().address(101)[null_bit / 8] >> (null_bit % 8)) & 1) == 0);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("WriteAheadLog/group commit", "[milestone1]")
+{
+    auto &table = create_table();
+    const std::string filename = std::string(P_tmpdir) + "/WriteAheadLogTest_group.log";
+    std::remove(filename.c_str());
+
+    constexpr unsigned NUM_THREADS = 4;
+    constexpr std::size_t NUM_COMMITS = 50;
+    {
+        /* Concurrent commits share syncs. */
+        WriteAheadLog log(filename.c_str(), std::chrono::milliseconds(2));
+        std::vector<std::thread> threads;
+        for (unsigned id = 0; id != NUM_THREADS; ++id) {
+            threads.emplace_back([&, id]() {
+                ColumnStore store(table);
+                store.attach_log(log, id);
+                for (std::size_t i = 0; i != NUM_COMMITS; ++i) {
+                    append_rows(store, 10 * i, 10);
+                    store.commit();
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        CHECK(log.num_syncs() < NUM_THREADS * NUM_COMMITS);
+    }
+
+    /* Every store recovers its own rows. */
+    WriteAheadLog log(filename.c_str());
+    for (unsigned id = 0; id != NUM_THREADS; ++id) {
+        RowStore store(table);
+        store.attach_log(log, id);
+        check_rows(store, 10 * NUM_COMMITS);
+    }
+    std::remove(filename.c_str());
+}